@@ -1,4 +1,5 @@
 #include "zendoo_mc.h"
+#include "zendoo_mc.hpp"
 #include "error.h"
 #include <stdio.h>
 #include <iostream>
@@ -7,6 +8,7 @@
 #include <string>
 #include <cassert>
 #include <vector>
+#include <iterator>
 
 void print_error(const char *msg) {
     Error err = zendoo_get_last_error();
@@ -167,6 +169,54 @@ void merkle_test() {
     std::cout<< "...ok" << std::endl;
 }
 
+void cpp_wrapper_test() {
+
+    std::cout << "C++ wrapper test" << std::endl;
+
+    //Generate random leaves, owned by the vector
+    std::vector<zendoo::field> leaves;
+    for (int i = 0; i < 16; i++){
+        leaves.push_back(zendoo::field::random());
+    }
+
+    //Leaves are passed to the library without copies
+    zendoo::ginger_mt tree(leaves);
+    auto root = tree.root();
+
+    //Verify Merkle Path is ok for each leaf
+    auto paths = tree.paths(leaves);
+    for (size_t i = 0; i < leaves.size(); i++) {
+        assert(("Merkle path not verified", paths[i].verify(leaves[i], root)));
+    }
+
+    //Hashing all the leaves at once or incrementally gives the same result
+    zendoo::poseidon_inputs inputs;
+    inputs.add(leaves);
+    assert(("Unexpected hash", inputs.hash() == zendoo::poseidon_hash(leaves)));
+
+    //Fields serialization round trip
+    std::vector<unsigned char> leaves_bytes(leaves.size() * SC_FIELD_SIZE);
+    zendoo::field::serialize(leaves, leaves_bytes);
+    auto leaves_deserialized = zendoo::field::deserialize(leaves_bytes);
+    for (size_t i = 0; i < leaves.size(); i++) {
+        assert(("Unexpected deserialized field", leaves[i] == leaves_deserialized[i]));
+    }
+
+    //Many proofs laid out contiguously are deserialized at once
+    std::ifstream is ("../test_files/sample_proof", std::ifstream::binary);
+    std::vector<unsigned char> proof_bytes((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    std::vector<unsigned char> proofs_bytes;
+    for (int i = 0; i < 4; i++) {
+        proofs_bytes.insert(proofs_bytes.end(), proof_bytes.begin(), proof_bytes.end());
+    }
+    auto proofs = zendoo::sc_proof::deserialize_many(proofs_bytes);
+    assert(("Unexpected number of proofs", proofs.size() == 4));
+    assert(("Unexpected serialized proof", proofs[3].serialize() == proof_bytes));
+
+    //All the objects are freed when going out of scope
+    std::cout<< "...ok" << std::endl;
+}
+
 void proof_test() {
 
     std::cout << "Zk proof test" << std::endl;
@@ -402,6 +452,7 @@ int main() {
     field_test();
     hash_test();
     merkle_test();
+    cpp_wrapper_test();
     proof_test();
     proof_test_no_bwt();
 }
\ No newline at end of file
@@ -1,3 +1,6 @@
+#ifndef ZENDOO_MC_ERROR_INCLUDE_H_
+#define ZENDOO_MC_ERROR_INCLUDE_H_
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -9,6 +12,23 @@
 
 #define CRYPTO_ERROR 2
 
+#define MEMORY_ERROR 3
+
+/*
+ * Error codes reported by the `_ex` functions.
+ */
+#define ERROR_CODE_OK 0
+
+#define ERROR_CODE_INVALID_FIELD 1
+
+#define ERROR_CODE_INVALID_SC_PROOF 2
+
+#define ERROR_CODE_INVALID_SC_VK 3
+
+#define ERROR_CODE_VERIFICATION_ERROR 4
+
+#define ERROR_CODE_MEMORY_BUDGET_EXCEEDED 5
+
 extern "C" {
     typedef struct {
       /*
@@ -28,6 +48,11 @@ extern "C" {
      */
     const char *zendoo_get_category_name(uint32_t category);
 
+    /*
+     * Get a short description of an error code.
+     */
+    const char *zendoo_get_error_code_message(uint32_t code);
+
     /*
      * Clear the `LAST_ERROR` variable.
      */
@@ -43,4 +68,6 @@ extern "C" {
      * calling any function which may set `LAST_ERROR`.
      */
     Error zendoo_get_last_error(void);
-}
\ No newline at end of file
+}
+
+#endif // ZENDOO_MC_ERROR_INCLUDE_H_
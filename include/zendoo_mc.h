@@ -7,6 +7,8 @@
 static const size_t SC_PROOF_SIZE = 771;
 static const size_t SC_VK_SIZE = 1544;
 static const size_t SC_FIELD_SIZE = 96;
+static const size_t SC_PROOF_COMPRESSED_SIZE = 387;
+static const size_t SC_VK_COMPRESSED_SIZE = 968;
 
 extern "C" {
 
@@ -43,6 +45,13 @@ extern "C" {
      */
     field_t* zendoo_deserialize_field(const unsigned char* field_bytes);
 
+    /*
+     * Same as `zendoo_deserialize_field`, but on failure no error message is built: the error
+     * code is written into `error_code` (if not NULL) and the corresponding message is only
+     * looked up when calling `zendoo_get_last_error`. `error_code` is set to ERROR_CODE_OK on success.
+     */
+    field_t* zendoo_deserialize_field_ex(const unsigned char* field_bytes, uint32_t* error_code);
+
     /*
      * Free the memory from the field pointed by `field`. It's caller responsibility
      * to set `field` to NULL afterwards. If `field` was already null, the function does
@@ -79,6 +88,66 @@ extern "C" {
      */
     sc_proof_t* zendoo_deserialize_sc_proof(const unsigned char* sc_proof_bytes);
 
+    /*
+     * Same as `zendoo_deserialize_sc_proof`, but return NULL if deserialization fails, reporting
+     * the failure only as an error code into `error_code` (if not NULL).
+     */
+    sc_proof_t* zendoo_deserialize_sc_proof_ex(const unsigned char* sc_proof_bytes, uint32_t* error_code);
+
+    /*
+     * Wire formats for sc_proof and sc_vk. UNCOMPRESSED is the one used by the functions
+     * without explicit format, and is the fastest to deserialize; COMPRESSED is smaller,
+     * but requires a square root per point when deserializing.
+     */
+    typedef enum sc_serialization_format {
+      SC_SERIALIZATION_UNCOMPRESSED = 0,
+      SC_SERIALIZATION_COMPRESSED = 1
+    } sc_serialization_format_t;
+
+    /*
+     * Get the number of bytes needed to serialize/deserialize a sc_proof in the specified `format`.
+     * Return 0 if `format` is unknown.
+     */
+    size_t zendoo_get_sc_proof_size_in_bytes_with_format(sc_serialization_format_t format);
+
+    /*
+     * Serialize a sc_proof, in the specified `format`, into `sc_proof_bytes` of len `sc_proof_bytes_len`
+     * given an opaque pointer `sc_proof` to it. `sc_proof_bytes_len` must be equal to the one returned by
+     * `zendoo_get_sc_proof_size_in_bytes_with_format`. Return false if serialization was unsuccessful.
+     */
+    bool zendoo_serialize_sc_proof_with_format(
+        const sc_proof_t* sc_proof,
+        sc_serialization_format_t format,
+        unsigned char* sc_proof_bytes,
+        size_t sc_proof_bytes_len
+    );
+
+    /*
+     * Deserialize a sc_proof, in the specified `format`, from `sc_proof_bytes` of len `sc_proof_bytes_len`
+     * and return an opaque pointer to it. `sc_proof_bytes_len` must be equal to the one returned by
+     * `zendoo_get_sc_proof_size_in_bytes_with_format`. Return NULL if deserialization fails.
+     */
+    sc_proof_t* zendoo_deserialize_sc_proof_with_format(
+        const unsigned char* sc_proof_bytes,
+        size_t sc_proof_bytes_len,
+        sc_serialization_format_t format
+    );
+
+    /*
+     * Deserialize `sc_proofs_len` sc_proofs, in the specified `format`, from `sc_proofs_bytes`, holding
+     * the serialized sc_proofs contiguously (zendoo_get_sc_proof_size_in_bytes_with_format bytes each).
+     * The sc_proofs are deserialized in parallel, and opaque pointers to them are written into
+     * `sc_proofs`, which must have room for `sc_proofs_len` pointers. Return false if any of them fails
+     * to deserialize: in that case no sc_proof is returned. If `sc_proofs_len` is 0 nothing is read
+     * (the buffers may be NULL) and true is returned; otherwise NULL buffers are rejected.
+     */
+    bool zendoo_deserialize_sc_proofs(
+        const unsigned char* sc_proofs_bytes,
+        size_t sc_proofs_len,
+        sc_serialization_format_t format,
+        sc_proof_t** sc_proofs
+    );
+
     /*
      * Free the memory from the sc_proof pointed by `sc_proof`. It's caller responsibility
      * to set `sc_proof` to NULL afterwards. If `sc_proof` was already NULL, the function does
@@ -106,6 +175,52 @@ extern "C" {
      */
     sc_vk_t* zendoo_deserialize_sc_vk(const unsigned char* sc_vk_bytes);
 
+    /*
+     * Same as `zendoo_deserialize_sc_vk`, but return NULL if deserialization fails, reporting
+     * the failure only as an error code into `error_code` (if not NULL).
+     */
+    sc_vk_t* zendoo_deserialize_sc_vk_ex(const unsigned char* sc_vk_bytes, uint32_t* error_code);
+
+    /*
+     * Get the number of bytes needed to serialize/deserialize a sc_vk in the specified `format`.
+     * Return 0 if `format` is unknown.
+     */
+    size_t zendoo_get_sc_vk_size_in_bytes_with_format(sc_serialization_format_t format);
+
+    /*
+     * Serialize a sc_vk, in the specified `format`, into `sc_vk_bytes` of len `sc_vk_bytes_len`
+     * given an opaque pointer `sc_vk` to it. `sc_vk_bytes_len` must be equal to the one returned by
+     * `zendoo_get_sc_vk_size_in_bytes_with_format`. Return false if serialization was unsuccessful.
+     */
+    bool zendoo_serialize_sc_vk_with_format(
+        const sc_vk_t* sc_vk,
+        sc_serialization_format_t format,
+        unsigned char* sc_vk_bytes,
+        size_t sc_vk_bytes_len
+    );
+
+    /*
+     * Deserialize a sc_vk, in the specified `format`, from `sc_vk_bytes` of len `sc_vk_bytes_len`
+     * and return an opaque pointer to it. `sc_vk_bytes_len` must be equal to the one returned by
+     * `zendoo_get_sc_vk_size_in_bytes_with_format`. Return NULL if deserialization fails.
+     */
+    sc_vk_t* zendoo_deserialize_sc_vk_with_format(
+        const unsigned char* sc_vk_bytes,
+        size_t sc_vk_bytes_len,
+        sc_serialization_format_t format
+    );
+
+    /*
+     * Same as `zendoo_deserialize_sc_proofs`, but for `sc_vks_len` sc_vks, each one taking
+     * zendoo_get_sc_vk_size_in_bytes_with_format bytes in `sc_vks_bytes`.
+     */
+    bool zendoo_deserialize_sc_vks(
+        const unsigned char* sc_vks_bytes,
+        size_t sc_vks_len,
+        sc_serialization_format_t format,
+        sc_vk_t** sc_vks
+    );
+
     /*
      * Free the memory from the sc_vk pointed by `sc_vk`. It's caller responsibility
      * to set `sc_vk` to NULL afterwards. If `sc_vk` was already null, the function does
@@ -113,6 +228,16 @@ extern "C" {
      */
     void zendoo_sc_vk_free(sc_vk_t* sc_vk);
 
+    /*
+     * Compute the Merkle root of the backward transfers in `bt_list` (which can be NULL if
+     * `bt_list_len` is 0), as used in the sc_proof public inputs. The BTs are consumed one at
+     * a time, without building the tree: memory usage doesn't depend on `bt_list_len`.
+     * Return an opaque pointer to the root, or NULL if some error occurred.
+     */
+    field_t* zendoo_compute_bt_root_streaming(
+        const backward_transfer_t* bt_list,
+        size_t bt_list_len
+    );
 
     /*  Verify a sc_proof given an opaque pointer `sc_proof` to it, an opaque pointer
      *  to the verification key `sc_vk` and all the data needed to construct
@@ -132,6 +257,74 @@ extern "C" {
         const sc_vk_t* sc_vk
     );
 
+    /*
+     * Same as `zendoo_verify_sc_proof`, but errors are reported only as an error code into
+     * `error_code` (if not NULL). A proof that simply doesn't verify is not an error: in that
+     * case false is returned and `error_code` is set to ERROR_CODE_OK.
+     */
+    bool zendoo_verify_sc_proof_ex(
+        const unsigned char* end_epoch_mc_b_hash,
+        const unsigned char* prev_end_epoch_mc_b_hash,
+        const backward_transfer_t* bt_list,
+        size_t bt_list_len,
+        uint64_t quality,
+        const field_t* constant,
+        const field_t* proofdata,
+        const sc_proof_t* sc_proof,
+        const sc_vk_t* sc_vk,
+        uint32_t* error_code
+    );
+
+    typedef struct cancellation_token cancellation_token_t;
+
+    /* Return an opaque pointer to a new, not cancelled, cancellation_token. */
+    cancellation_token_t* zendoo_cancellation_token_new(void);
+
+    /*
+     * Cancel the verifications using the cancellation_token pointed by `token`.
+     * Can be called from any thread.
+     */
+    void zendoo_cancellation_token_cancel(const cancellation_token_t* token);
+
+    /* Restore the cancellation_token pointed by `token`, so that it can be reused. */
+    void zendoo_cancellation_token_reset(const cancellation_token_t* token);
+
+    /*
+     * Free the memory from the cancellation_token pointed by `token`. It's caller responsibility
+     * to set `token` to NULL afterwards, and to make sure no verification is still using it.
+     * If `token` was already NULL, the function does nothing.
+     */
+    void zendoo_cancellation_token_free(cancellation_token_t* token);
+
+    typedef enum sc_proof_verification_status {
+      SC_PROOF_INVALID = 0,
+      SC_PROOF_VALID = 1,
+      SC_PROOF_VERIFICATION_CANCELLED = 2,
+      SC_PROOF_VERIFICATION_DEADLINE_EXCEEDED = 3,
+      SC_PROOF_VERIFICATION_ERROR = 4
+    } sc_proof_verification_status_t;
+
+    /*
+     * Same as `zendoo_verify_sc_proof`, but the verification is abandoned, between two of its
+     * stages, as soon as the cancellation_token pointed by `token` is cancelled, or `timeout_ms`
+     * milliseconds have elapsed from the call. `token` can be NULL and `timeout_ms` can be 0,
+     * meaning respectively no cancellation and no timeout. Return the outcome of the verification;
+     * in case of SC_PROOF_VERIFICATION_ERROR, the error can be retrieved with `zendoo_get_last_error`.
+     */
+    sc_proof_verification_status_t zendoo_verify_sc_proof_interruptible(
+        const unsigned char* end_epoch_mc_b_hash,
+        const unsigned char* prev_end_epoch_mc_b_hash,
+        const backward_transfer_t* bt_list,
+        size_t bt_list_len,
+        uint64_t quality,
+        const field_t* constant,
+        const field_t* proofdata,
+        const sc_proof_t* sc_proof,
+        const sc_vk_t* sc_vk,
+        const cancellation_token_t* token,
+        uint64_t timeout_ms
+    );
+
 //Poseidon hash related functions
 
     /*
@@ -144,6 +337,57 @@ extern "C" {
         size_t input_len
     );
 
+    typedef struct poseidon_inputs poseidon_inputs_t;
+
+    /*
+     * Return an opaque pointer to an empty buffer of Poseidon inputs, to which inputs can be
+     * added incrementally. Hashing it gives the same result as calling
+     * `zendoo_compute_poseidon_hash` on all the inputs added, in order.
+     * Note that it's not a sponge: all the inputs are kept until hashing, so the buffer takes
+     * memory proportional to them.
+     */
+    poseidon_inputs_t* zendoo_init_poseidon_inputs(void);
+
+    /*
+     * Add the field pointed by `input` to the poseidon_inputs pointed by `inputs`.
+     * Return false if some error occurred.
+     */
+    bool zendoo_add_poseidon_input(
+        poseidon_inputs_t* inputs,
+        const field_t* input
+    );
+
+    /*
+     * Add `input` bytes of len `input_len` to the poseidon_inputs pointed by `inputs`, as field
+     * elements read from consecutive chunks of 94 bytes (the last one padded with zeros).
+     * Return false if some error occurred.
+     */
+    bool zendoo_add_poseidon_input_bytes(
+        poseidon_inputs_t* inputs,
+        const unsigned char* input,
+        size_t input_len
+    );
+
+    /*
+     * Return an opaque pointer to the hash of the inputs added so far to the poseidon_inputs
+     * pointed by `inputs`, or NULL if some error occurred. The inputs are left untouched, so
+     * more inputs can be added afterwards.
+     */
+    field_t* zendoo_hash_poseidon_inputs(const poseidon_inputs_t* inputs);
+
+    /*
+     * Return an opaque pointer to a copy of the poseidon_inputs pointed by `inputs`.
+     * The copy takes memory proportional to the inputs, and hashing it hashes all of them again.
+     */
+    poseidon_inputs_t* zendoo_clone_poseidon_inputs(const poseidon_inputs_t* inputs);
+
+    /*
+     * Free the memory from the poseidon_inputs pointed by `inputs`. It's caller responsibility
+     * to set `inputs` to NULL afterwards. If `inputs` was already NULL, the function does
+     * nothing.
+     */
+    void zendoo_poseidon_inputs_free(poseidon_inputs_t* inputs);
+
 //Poseidon-based Merkle Tree related functions
 
     typedef struct ginger_mt      ginger_mt_t;
@@ -159,6 +403,41 @@ extern "C" {
         size_t leaves_len
     );
 
+    /*
+     * Like ginger_mt_new, but the nodes of the tree are saved in the file at `tree_path`
+     * (replacing it atomically if already existing). The returned ginger_mt is backed by
+     * a memory mapping of that file: getting its root or a Merkle path doesn't require any
+     * hashing. The file can be opened again later by calling ginger_mt_open.
+     * Return NULL if some error occurred.
+     */
+    ginger_mt_t* ginger_mt_new_persistent(
+        const field_t** leaves,
+        size_t leaves_len,
+        const path_char_t* tree_path,
+        size_t tree_path_len
+    );
+
+    /*
+     * Open the ginger_mt saved at `tree_path` by ginger_mt_new_persistent or ginger_mt_save, memory mapping
+     * it without rehashing. The file must not be modified while the tree is open.
+     * Return NULL if the file can't be opened or if it's not a valid ginger_mt.
+     */
+    ginger_mt_t* ginger_mt_open(
+        const path_char_t* tree_path,
+        size_t tree_path_len
+    );
+
+    /*
+     * Save the nodes of `tree` in the file at `tree_path` (replacing it atomically if
+     * already existing), so that it can be opened later by calling ginger_mt_open.
+     * Return false if some error occurred.
+     */
+    bool ginger_mt_save(
+        const ginger_mt_t* tree,
+        const path_char_t* tree_path,
+        size_t tree_path_len
+    );
+
     /* Return an opaque pointer to the root of a ginger_mt given an opaque pointer `tree` to it */
     field_t* ginger_mt_get_root(
         const ginger_mt_t* tree
@@ -205,6 +484,41 @@ extern "C" {
         ginger_mt_path_t* path
     );
 
+//Memory accounting functions
+
+    /* Kinds of objects owned by the library, indexing the arrays in zendoo_memory_usage_t */
+    typedef enum zendoo_object_kind {
+      ZENDOO_OBJECT_FIELD = 0,
+      ZENDOO_OBJECT_SC_PROOF = 1,
+      ZENDOO_OBJECT_SC_VK = 2,
+      ZENDOO_OBJECT_GINGER_MT = 3,
+      ZENDOO_OBJECT_GINGER_MT_PATH = 4,
+      ZENDOO_OBJECT_POSEIDON_INPUTS = 5,
+      ZENDOO_OBJECT_KINDS = 6
+    } zendoo_object_kind_t;
+
+    typedef struct zendoo_memory_usage {
+      /* Number of live objects of each kind */
+      size_t live_objects[ZENDOO_OBJECT_KINDS];
+      /* Bytes held by live objects of each kind */
+      size_t live_bytes[ZENDOO_OBJECT_KINDS];
+      /* Bytes held by all live objects, plus the ones of the trees being built by ginger_mt_new_persistent */
+      size_t total_bytes;
+      /* Current memory budget (0 means unlimited) */
+      size_t budget;
+    } zendoo_memory_usage_t;
+
+    /* Get the memory currently held by the objects owned by the library. */
+    zendoo_memory_usage_t zendoo_get_memory_usage(void);
+
+    /*
+     * Set to `budget` bytes the maximum memory the library is allowed to hold (0 means unlimited,
+     * which is the default). Once the budget would be exceeded, functions returning new objects
+     * return NULL (or false) instead, reporting a MEMORY_ERROR through `zendoo_get_last_error`.
+     * Memory already held is not affected.
+     */
+    void zendoo_set_memory_budget(size_t budget);
+
 //Test functions
 
     /* Deserialize a sc_proof from a file at path `proof_path` and return an opaque pointer to it.
@@ -221,7 +535,25 @@ extern "C" {
         size_t params_dir_len
     );
 
-    /* Generates, given the required witnesses and the proving key, a MCTestCircuit proof, and saves it at specified path */
+    /*
+     * Deterministically generates from `seed` (32 bytes) and saves at specified path params_dir the
+     * proving key and verification key for MCTestCircuit. If `cache_dir` is not NULL, parameters
+     * previously generated from the same seed are reused from it, otherwise the new ones are
+     * stored there.
+     */
+    bool zendoo_generate_mc_test_params_from_seed(
+        const path_char_t* params_dir,
+        size_t params_dir_len,
+        const unsigned char* seed,
+        const path_char_t* cache_dir,
+        size_t cache_dir_len
+    );
+
+    /*
+     * Generates, given the required witnesses and the proving key, a MCTestCircuit proof, and saves it at specified path.
+     * The prover runs on a pool of `num_threads` threads, built on first use and then reused:
+     * 0 means using the global rayon pool (all the available cores, by default).
+     */
     bool zendoo_create_mc_test_proof(
         const unsigned char* end_epoch_mc_b_hash,
         const unsigned char* prev_end_epoch_mc_b_hash,
@@ -232,7 +564,8 @@ extern "C" {
         const path_char_t* pk_path,
         size_t pk_path_len,
         const path_char_t* proof_path,
-        size_t proof_path_len
+        size_t proof_path_len,
+        size_t num_threads
     );
 
     /* Get an opaque pointer to a random field element */
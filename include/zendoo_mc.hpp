@@ -0,0 +1,437 @@
+#ifndef ZENDOO_MC_INCLUDE_HPP_
+#define ZENDOO_MC_INCLUDE_HPP_
+
+#include "zendoo_mc.h"
+#include "error.h"
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Header-only C++ wrapper around the C API in zendoo_mc.h:
+ * - objects owned by the library are wrapped by move-only handles, freeing them on destruction;
+ * - functions taking lists of objects accept a `zendoo::span` over contiguous storage
+ *   (a std::vector, std::array or C array of handles), which is passed straight through
+ *   without building intermediate arrays of raw pointers;
+ * - errors reported by the library are thrown as `zendoo::error`.
+ */
+namespace zendoo {
+
+//Error handling
+
+    class error : public std::runtime_error {
+    public:
+        error(const std::string& msg, uint32_t category):
+            std::runtime_error(msg), category_(category) {}
+
+        uint32_t category() const noexcept { return category_; }
+
+    private:
+        uint32_t category_;
+    };
+
+    /* Throw the most recent error reported by the library, prefixed by `what`. */
+    [[noreturn]] inline void throw_last_error(const std::string& what) {
+        Error err = zendoo_get_last_error();
+        std::string msg = what;
+        if (err.msg != NULL) {
+            msg += ": ";
+            msg += err.msg;
+        }
+        zendoo_clear_error();
+        throw error(msg, err.category);
+    }
+
+    template <typename T>
+    T* check_not_null(T* ptr, const char* what) {
+        if (ptr == NULL)
+            throw_last_error(what);
+        return ptr;
+    }
+
+//Contiguous views
+
+    /*
+     * Non-owning view over `size` contiguous objects of type T, in the style of C++20 std::span.
+     */
+    template <typename T>
+    class span {
+    public:
+        span() noexcept: data_(NULL), size_(0) {}
+        span(T* data, size_t size) noexcept: data_(data), size_(size) {}
+
+        template <size_t N>
+        span(T (&arr)[N]) noexcept: data_(arr), size_(N) {}
+
+        template <typename U, size_t N,
+                  typename = typename std::enable_if<std::is_convertible<U(*)[], T(*)[]>::value>::type>
+        span(std::array<U, N>& arr) noexcept: data_(arr.data()), size_(N) {}
+
+        template <typename U, size_t N,
+                  typename = typename std::enable_if<std::is_convertible<const U(*)[], T(*)[]>::value>::type>
+        span(const std::array<U, N>& arr) noexcept: data_(arr.data()), size_(N) {}
+
+        template <typename U, typename A,
+                  typename = typename std::enable_if<std::is_convertible<U(*)[], T(*)[]>::value>::type>
+        span(std::vector<U, A>& vec) noexcept: data_(vec.data()), size_(vec.size()) {}
+
+        template <typename U, typename A,
+                  typename = typename std::enable_if<std::is_convertible<const U(*)[], T(*)[]>::value>::type>
+        span(const std::vector<U, A>& vec) noexcept: data_(vec.data()), size_(vec.size()) {}
+
+        T* data() const noexcept { return data_; }
+        size_t size() const noexcept { return size_; }
+        bool empty() const noexcept { return size_ == 0; }
+
+        T* begin() const noexcept { return data_; }
+        T* end() const noexcept { return data_ + size_; }
+        T& operator[](size_t i) const noexcept { return data_[i]; }
+
+        span subspan(size_t offset, size_t count) const noexcept { return span(data_ + offset, count); }
+
+    private:
+        T* data_;
+        size_t size_;
+    };
+
+//Owning handles
+
+    namespace detail {
+
+        /*
+         * Move-only owner of a pointer to a library object. It holds nothing but the pointer,
+         * so that an array of handles has the same layout of an array of pointers.
+         */
+        template <typename T, void (*Free)(T*)>
+        class handle {
+        public:
+            handle() noexcept: ptr_(NULL) {}
+            explicit handle(T* ptr) noexcept: ptr_(ptr) {}
+
+            handle(const handle&) = delete;
+            handle& operator=(const handle&) = delete;
+
+            handle(handle&& other) noexcept: ptr_(other.release()) {}
+            handle& operator=(handle&& other) noexcept {
+                reset(other.release());
+                return *this;
+            }
+
+            ~handle() { reset(); }
+
+            T* get() const noexcept { return ptr_; }
+            explicit operator bool() const noexcept { return ptr_ != NULL; }
+
+            T* release() noexcept {
+                T* ptr = ptr_;
+                ptr_ = NULL;
+                return ptr;
+            }
+
+            void reset(T* ptr = NULL) noexcept {
+                if (ptr_ != NULL)
+                    Free(ptr_);
+                ptr_ = ptr;
+            }
+
+        private:
+            T* ptr_;
+        };
+
+        /* Reinterpret contiguous handles as the array of pointers expected by the C API. */
+        template <typename H, typename T>
+        const T** as_ptr_array(span<const H> handles) {
+            static_assert(sizeof(H) == sizeof(T*) && std::is_standard_layout<H>::value,
+                          "handle must have the same layout of a pointer");
+            return const_cast<const T**>(reinterpret_cast<const T* const*>(handles.data()));
+        }
+    }
+
+    class field : public detail::handle<field_t, zendoo_field_free> {
+    public:
+        using handle::handle;
+
+        static field deserialize(const unsigned char* field_bytes) {
+            return field(check_not_null(zendoo_deserialize_field(field_bytes), "unable to deserialize field"));
+        }
+
+        /* Deserialize fields from `fields_bytes`, holding SC_FIELD_SIZE contiguous bytes for each one */
+        static std::vector<field> deserialize(span<const unsigned char> fields_bytes) {
+            if (fields_bytes.size() % SC_FIELD_SIZE != 0)
+                throw error("unexpected size for serialized fields", GENERAL_ERROR);
+
+            std::vector<field> fields;
+            fields.reserve(fields_bytes.size() / SC_FIELD_SIZE);
+            for (size_t i = 0; i < fields_bytes.size(); i += SC_FIELD_SIZE)
+                fields.push_back(deserialize(fields_bytes.data() + i));
+            return fields;
+        }
+
+        static field random() {
+            return field(check_not_null(zendoo_get_random_field(), "unable to create field"));
+        }
+
+        std::array<unsigned char, SC_FIELD_SIZE> serialize() const {
+            std::array<unsigned char, SC_FIELD_SIZE> field_bytes;
+            zendoo_serialize_field(get(), field_bytes.data());
+            return field_bytes;
+        }
+
+        /* Serialize `fields` into `fields_bytes`, which must have SC_FIELD_SIZE contiguous bytes for each one */
+        static void serialize(span<const field> fields, span<unsigned char> fields_bytes) {
+            if (fields_bytes.size() != fields.size() * SC_FIELD_SIZE)
+                throw error("unexpected size for serialized fields", GENERAL_ERROR);
+
+            for (size_t i = 0; i < fields.size(); i++)
+                zendoo_serialize_field(fields[i].get(), fields_bytes.data() + i * SC_FIELD_SIZE);
+        }
+
+        bool operator==(const field& other) const { return zendoo_field_assert_eq(get(), other.get()); }
+        bool operator!=(const field& other) const { return !(*this == other); }
+    };
+
+    class sc_proof : public detail::handle<sc_proof_t, zendoo_sc_proof_free> {
+    public:
+        using handle::handle;
+
+        static sc_proof deserialize(
+            span<const unsigned char> sc_proof_bytes,
+            sc_serialization_format_t format = SC_SERIALIZATION_UNCOMPRESSED
+        ) {
+            return sc_proof(check_not_null(
+                zendoo_deserialize_sc_proof_with_format(sc_proof_bytes.data(), sc_proof_bytes.size(), format),
+                "unable to deserialize sc_proof"
+            ));
+        }
+
+        /* Deserialize, in parallel, the sc_proofs laid out contiguously in `sc_proofs_bytes` */
+        static std::vector<sc_proof> deserialize_many(
+            span<const unsigned char> sc_proofs_bytes,
+            sc_serialization_format_t format = SC_SERIALIZATION_UNCOMPRESSED
+        ) {
+            size_t sc_proof_size = zendoo_get_sc_proof_size_in_bytes_with_format(format);
+            if (sc_proof_size == 0 || sc_proofs_bytes.size() % sc_proof_size != 0)
+                throw error("unexpected size for serialized sc_proofs", GENERAL_ERROR);
+
+            std::vector<sc_proof_t*> ptrs(sc_proofs_bytes.size() / sc_proof_size);
+            if (!zendoo_deserialize_sc_proofs(sc_proofs_bytes.data(), ptrs.size(), format, ptrs.data()))
+                throw_last_error("unable to deserialize sc_proofs");
+            return std::vector<sc_proof>(ptrs.begin(), ptrs.end());
+        }
+
+        std::vector<unsigned char> serialize(sc_serialization_format_t format = SC_SERIALIZATION_UNCOMPRESSED) const {
+            std::vector<unsigned char> sc_proof_bytes(zendoo_get_sc_proof_size_in_bytes_with_format(format));
+            if (!zendoo_serialize_sc_proof_with_format(get(), format, sc_proof_bytes.data(), sc_proof_bytes.size()))
+                throw_last_error("unable to serialize sc_proof");
+            return sc_proof_bytes;
+        }
+
+        static sc_proof from_file(const path_char_t* proof_path, size_t proof_path_len) {
+            return sc_proof(check_not_null(
+                zendoo_deserialize_sc_proof_from_file(proof_path, proof_path_len),
+                "unable to read sc_proof from file"
+            ));
+        }
+    };
+
+    class sc_vk : public detail::handle<sc_vk_t, zendoo_sc_vk_free> {
+    public:
+        using handle::handle;
+
+        static sc_vk deserialize(
+            span<const unsigned char> sc_vk_bytes,
+            sc_serialization_format_t format = SC_SERIALIZATION_UNCOMPRESSED
+        ) {
+            return sc_vk(check_not_null(
+                zendoo_deserialize_sc_vk_with_format(sc_vk_bytes.data(), sc_vk_bytes.size(), format),
+                "unable to deserialize sc_vk"
+            ));
+        }
+
+        /* Deserialize, in parallel, the sc_vks laid out contiguously in `sc_vks_bytes` */
+        static std::vector<sc_vk> deserialize_many(
+            span<const unsigned char> sc_vks_bytes,
+            sc_serialization_format_t format = SC_SERIALIZATION_UNCOMPRESSED
+        ) {
+            size_t sc_vk_size = zendoo_get_sc_vk_size_in_bytes_with_format(format);
+            if (sc_vk_size == 0 || sc_vks_bytes.size() % sc_vk_size != 0)
+                throw error("unexpected size for serialized sc_vks", GENERAL_ERROR);
+
+            std::vector<sc_vk_t*> ptrs(sc_vks_bytes.size() / sc_vk_size);
+            if (!zendoo_deserialize_sc_vks(sc_vks_bytes.data(), ptrs.size(), format, ptrs.data()))
+                throw_last_error("unable to deserialize sc_vks");
+            return std::vector<sc_vk>(ptrs.begin(), ptrs.end());
+        }
+
+        std::vector<unsigned char> serialize(sc_serialization_format_t format = SC_SERIALIZATION_UNCOMPRESSED) const {
+            std::vector<unsigned char> sc_vk_bytes(zendoo_get_sc_vk_size_in_bytes_with_format(format));
+            if (!zendoo_serialize_sc_vk_with_format(get(), format, sc_vk_bytes.data(), sc_vk_bytes.size()))
+                throw_last_error("unable to serialize sc_vk");
+            return sc_vk_bytes;
+        }
+
+        static sc_vk from_file(const path_char_t* vk_path, size_t vk_path_len) {
+            return sc_vk(check_not_null(
+                zendoo_deserialize_sc_vk_from_file(vk_path, vk_path_len),
+                "unable to read sc_vk from file"
+            ));
+        }
+
+        bool operator==(const sc_vk& other) const { return zendoo_sc_vk_assert_eq(get(), other.get()); }
+        bool operator!=(const sc_vk& other) const { return !(*this == other); }
+    };
+
+    /*
+     * Verify `proof` against `vk` and the given public inputs. Return false if the proof
+     * is not valid, throw if some error occurred. `constant` and `proofdata` can be NULL.
+     */
+    inline bool verify_sc_proof(
+        const std::array<unsigned char, 32>& end_epoch_mc_b_hash,
+        const std::array<unsigned char, 32>& prev_end_epoch_mc_b_hash,
+        span<const backward_transfer_t> bt_list,
+        uint64_t quality,
+        const field* constant,
+        const field* proofdata,
+        const sc_proof& proof,
+        const sc_vk& vk
+    ) {
+        uint32_t error_code = ERROR_CODE_OK;
+        bool result = zendoo_verify_sc_proof_ex(
+            end_epoch_mc_b_hash.data(),
+            prev_end_epoch_mc_b_hash.data(),
+            bt_list.data(),
+            bt_list.size(),
+            quality,
+            constant != NULL ? constant->get() : NULL,
+            proofdata != NULL ? proofdata->get() : NULL,
+            proof.get(),
+            vk.get(),
+            &error_code
+        );
+        if (error_code != ERROR_CODE_OK)
+            throw_last_error("unable to verify sc_proof");
+        return result;
+    }
+
+//Poseidon hash
+
+    /* Compute the Poseidon Hash of `input`, passed to the library as it is. */
+    inline field poseidon_hash(span<const field> input) {
+        return field(check_not_null(
+            zendoo_compute_poseidon_hash(detail::as_ptr_array<field, field_t>(input), input.size()),
+            "unable to compute poseidon hash"
+        ));
+    }
+
+    /* Buffer of Poseidon inputs: all of them are kept, and hashed at once by hash(). */
+    class poseidon_inputs : public detail::handle<poseidon_inputs_t, zendoo_poseidon_inputs_free> {
+    public:
+        using handle::handle;
+
+        poseidon_inputs(): handle(check_not_null(zendoo_init_poseidon_inputs(), "unable to create poseidon inputs")) {}
+
+        poseidon_inputs& add(const field& input) {
+            if (!zendoo_add_poseidon_input(get(), input.get()))
+                throw_last_error("unable to add poseidon input");
+            return *this;
+        }
+
+        poseidon_inputs& add(span<const field> inputs) {
+            for (const field& input: inputs)
+                add(input);
+            return *this;
+        }
+
+        poseidon_inputs& add(span<const unsigned char> bytes) {
+            if (!zendoo_add_poseidon_input_bytes(get(), bytes.data(), bytes.size()))
+                throw_last_error("unable to add poseidon input");
+            return *this;
+        }
+
+        field hash() const {
+            return field(check_not_null(zendoo_hash_poseidon_inputs(get()), "unable to hash poseidon inputs"));
+        }
+
+        poseidon_inputs clone() const {
+            return poseidon_inputs(check_not_null(zendoo_clone_poseidon_inputs(get()), "unable to clone poseidon inputs"));
+        }
+
+    private:
+        explicit poseidon_inputs(poseidon_inputs_t* inputs): handle(inputs) {}
+    };
+
+//Poseidon-based Merkle Tree
+
+    class ginger_mt_path : public detail::handle<ginger_mt_path_t, ginger_mt_path_free> {
+    public:
+        using handle::handle;
+
+        bool verify(const field& leaf, const field& root) const {
+            return ginger_mt_verify_merkle_path(leaf.get(), root.get(), get());
+        }
+    };
+
+    class ginger_mt : public detail::handle<ginger_mt_t, ginger_mt_free> {
+    public:
+        using handle::handle;
+
+        /* Build a ginger_mt on `leaves`, passed to the library as they are. */
+        explicit ginger_mt(span<const field> leaves): handle(check_not_null(
+            ginger_mt_new(detail::as_ptr_array<field, field_t>(leaves), leaves.size()),
+            "unable to create ginger_mt"
+        )) {}
+
+        /* Build a ginger_mt on `leaves` and save it at `tree_path`. */
+        static ginger_mt persistent(span<const field> leaves, const path_char_t* tree_path, size_t tree_path_len) {
+            return ginger_mt(check_not_null(
+                ginger_mt_new_persistent(
+                    detail::as_ptr_array<field, field_t>(leaves), leaves.size(), tree_path, tree_path_len
+                ),
+                "unable to create persistent ginger_mt"
+            ));
+        }
+
+        /* Open a ginger_mt previously saved with persistent() or save(). */
+        static ginger_mt open(const path_char_t* tree_path, size_t tree_path_len) {
+            return ginger_mt(check_not_null(
+                ginger_mt_open(tree_path, tree_path_len),
+                "unable to open ginger_mt"
+            ));
+        }
+
+        void save(const path_char_t* tree_path, size_t tree_path_len) const {
+            if (!ginger_mt_save(get(), tree_path, tree_path_len)) {
+                throw_last_error("unable to save ginger_mt");
+            }
+        }
+
+        field root() const {
+            return field(check_not_null(ginger_mt_get_root(get()), "unable to get ginger_mt root"));
+        }
+
+        ginger_mt_path path(const field& leaf, size_t leaf_index) const {
+            return ginger_mt_path(check_not_null(
+                ginger_mt_get_merkle_path(leaf.get(), leaf_index, get()),
+                "unable to get ginger_mt_path"
+            ));
+        }
+
+        /* Get the paths of all `leaves`, which must be the ones the tree was built on. */
+        std::vector<ginger_mt_path> paths(span<const field> leaves) const {
+            std::vector<ginger_mt_path> paths;
+            paths.reserve(leaves.size());
+            for (size_t i = 0; i < leaves.size(); i++)
+                paths.push_back(path(leaves[i], i));
+            return paths;
+        }
+    };
+
+    static_assert(sizeof(field) == sizeof(field_t*), "field must be layout compatible with field_t*");
+}
+
+#endif // ZENDOO_MC_INCLUDE_HPP_
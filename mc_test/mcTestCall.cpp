@@ -79,7 +79,8 @@ void create_verify(int argc, char** argv)
         (path_char_t*)pk_path.c_str(),
         pk_path_len,
         (path_char_t*)proof_path.c_str(),
-        proof_path_len
+        proof_path_len,
+        0
     ));
 
     // If -v was specified we verify the proof just created
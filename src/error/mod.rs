@@ -6,6 +6,17 @@ use std::ptr;
 pub const GENERAL_ERROR: u32 = 0;
 pub const IO_ERROR: u32 = 1;
 pub const CRYPTO_ERROR: u32 = 2;
+pub const MEMORY_ERROR: u32 = 3;
+
+/// Numeric error codes reported by the `_ex` functions. Setting them doesn't
+/// allocate nor format anything: the message text is a static string only
+/// looked up when `zendoo_get_last_error()` is called.
+pub const ERROR_CODE_OK: u32 = 0;
+pub const ERROR_CODE_INVALID_FIELD: u32 = 1;
+pub const ERROR_CODE_INVALID_SC_PROOF: u32 = 2;
+pub const ERROR_CODE_INVALID_SC_VK: u32 = 3;
+pub const ERROR_CODE_VERIFICATION_ERROR: u32 = 4;
+pub const ERROR_CODE_MEMORY_BUDGET_EXCEEDED: u32 = 5;
 
 type StdError = Box<dyn std::error::Error>;
 
@@ -36,11 +47,38 @@ pub extern "C" fn zendoo_get_category_name(category: u32) -> *const c_char {
         GENERAL_ERROR => b"General\0",
         IO_ERROR => b"Unable to read/write\0",
         CRYPTO_ERROR => b"Crypto error\0",
+        MEMORY_ERROR => b"Memory budget exceeded\0",
         _ => b"Unknown\0",
     };
     s.as_ptr() as *const c_char
 }
 
+/// Get a short description of an error code.
+#[no_mangle]
+pub extern "C" fn zendoo_get_error_code_message(code: u32) -> *const c_char {
+    // NOTE: Update this every time a new error code constant is added
+    let s: &[u8] = match code {
+        ERROR_CODE_OK => b"No error\0",
+        ERROR_CODE_INVALID_FIELD => b"Unable to read field element from buffer\0",
+        ERROR_CODE_INVALID_SC_PROOF => b"Unable to read sc_proof from buffer\0",
+        ERROR_CODE_INVALID_SC_VK => b"Unable to read sc_vk from buffer\0",
+        ERROR_CODE_VERIFICATION_ERROR => b"Error while verifying sc_proof\0",
+        ERROR_CODE_MEMORY_BUDGET_EXCEEDED => b"Memory budget exceeded\0",
+        _ => b"Unknown\0",
+    };
+    s.as_ptr() as *const c_char
+}
+
+/// Get the category an error code belongs to.
+pub fn get_error_code_category(code: u32) -> u32 {
+    match code {
+        ERROR_CODE_INVALID_FIELD | ERROR_CODE_INVALID_SC_PROOF | ERROR_CODE_INVALID_SC_VK => IO_ERROR,
+        ERROR_CODE_VERIFICATION_ERROR => CRYPTO_ERROR,
+        ERROR_CODE_MEMORY_BUDGET_EXCEEDED => MEMORY_ERROR,
+        _ => GENERAL_ERROR,
+    }
+}
+
 thread_local! {
     /// An `errno`-like thread-local variable which keeps track of the most
     /// recent error to occur.
@@ -48,10 +86,13 @@ thread_local! {
 }
 
 #[derive(Debug)]
-struct LastError {
-    pub error: StdError,
-    pub c_string: CString,
-    pub category: u32,
+enum LastError {
+    Full {
+        error: StdError,
+        c_string: CString,
+        category: u32,
+    },
+    Code(u32),
 }
 
 /// Extra information about an error.
@@ -83,7 +124,7 @@ pub fn set_last_error(err: StdError, category: u32) {
     LAST_ERROR.with(|l| {
         let c_string = CString::new(err.to_string()).unwrap_or_default();
 
-        let new_error = LastError {
+        let new_error = LastError::Full {
             error: err,
             c_string,
             category,
@@ -93,6 +134,11 @@ pub fn set_last_error(err: StdError, category: u32) {
     });
 }
 
+/// Store `code` as the most recent error, without allocating anything.
+pub fn set_last_error_code(code: u32) {
+    LAST_ERROR.with(|l| *l.borrow_mut() = Some(LastError::Code(code)));
+}
+
 /// Retrieve the most recent `Error` from the `LAST_ERROR` variable.
 ///
 /// # Safety
@@ -103,9 +149,13 @@ pub fn set_last_error(err: StdError, category: u32) {
 #[no_mangle]
 pub unsafe extern "C" fn zendoo_get_last_error() -> Error {
     LAST_ERROR.with(|l| match l.borrow().as_ref() {
-        Some(err) => Error {
-            msg: err.c_string.as_ptr(),
-            category: err.category,
+        Some(LastError::Full { c_string, category, .. }) => Error {
+            msg: c_string.as_ptr(),
+            category: *category,
+        },
+        Some(LastError::Code(code)) => Error {
+            msg: zendoo_get_error_code_message(*code),
+            category: get_error_code_category(*code),
         },
         None => Error::default(),
     })
@@ -1,10 +1,17 @@
 use algebra::{
-    curves::mnt4753::MNT4 as PairingCurve,
-    fields::{mnt4753::Fr, PrimeField},
+    curves::{
+        mnt4753::{G1Affine, G2Affine, MNT4 as PairingCurve},
+        AffineCurve, PairingEngine, ProjectiveCurve,
+    },
+    fields::{
+        mnt4753::{Fq, Fq2, Fr},
+        Field, PrimeField,
+    },
     BigInteger768, FromBytes, ToBytes,
 };
 
-use crate::BackwardTransfer;
+use crate::{persistent_mht::PersistentGingerMerkleTree, BackwardTransfer};
+use lazy_static::lazy_static;
 use primitives::{
     crh::{FieldBasedHash, MNT4PoseidonHash as FieldHash},
     merkle_tree::field_based_mht::{
@@ -12,12 +19,25 @@ use primitives::{
     },
 };
 use proof_systems::groth16::{prepare_verifying_key, verifier::verify_proof, Proof, VerifyingKey};
+use rayon::prelude::*;
 
-use std::{fs::File, io::Result as IoResult, path::Path};
+use std::{
+    fs::File,
+    io::{BufReader, BufWriter, Error as IoError, ErrorKind, Read, Result as IoResult, Write},
+    path::{Path, PathBuf},
+    sync::atomic::{AtomicBool, AtomicUsize, Ordering},
+    time::Instant,
+};
 pub type Error = Box<dyn std::error::Error>;
 
 #[cfg(feature = "mc-test-circuit")]
 use crate::MCTestCircuit;
+#[cfg(feature = "mc-test-circuit")]
+use std::fs;
+#[cfg(feature = "mc-test-circuit")]
+use rayon::ThreadPool;
+#[cfg(feature = "mc-test-circuit")]
+use std::sync::{Arc, Mutex};
 
 pub type FieldElement = Fr;
 
@@ -29,6 +49,12 @@ pub const GROTH_PROOF_SIZE: usize = 771;
 // Assuming 1 public input: (2G1 + 2G2 + 1GT) = 1540 + 4 byte to save size of gamma_abc_g1 vec
 pub const VK_SIZE: usize = 1544;
 
+// Compressed points only keep the x coordinate and a flags byte: (2G1 + 1G2)
+pub const GROTH_PROOF_COMPRESSED_SIZE: usize = 387;
+
+// Assuming 1 public input: (2G1 + 2G2 + 1GT) = 964 + 4 byte to save size of gamma_abc_g1 vec
+pub const VK_COMPRESSED_SIZE: usize = 968;
+
 //*******************************Generic I/O functions**********************************************
 // Note: Should decide if panicking or handling IO errors
 
@@ -41,11 +67,31 @@ pub fn serialize_to_buffer<T: ToBytes>(to_write: &T, buffer: &mut [u8]) -> IoRes
 }
 
 pub fn read_from_file<T: FromBytes>(file_path: &Path) -> IoResult<T> {
-    let mut fs = File::open(file_path)?;
+    // FromBytes impls issue many small reads: buffer them instead of hitting the fs each time
+    let mut fs = BufReader::new(File::open(file_path)?);
     let t = T::read(&mut fs)?;
     Ok(t)
 }
 
+pub fn write_to_file<T: ToBytes>(to_write: &T, file_path: &Path) -> IoResult<()> {
+    let mut fs = BufWriter::new(File::create(file_path)?);
+    to_write.write(&mut fs)?;
+    fs.flush()
+}
+
+/// Return a path next to `path`, to write to before atomically renaming it to `path`.
+/// The name is unique among the threads of all the running processes.
+pub fn get_tmp_path(path: &Path) -> PathBuf {
+    static TMP_COUNTER: AtomicUsize = AtomicUsize::new(0);
+    let mut file_name = path.file_name().unwrap_or_default().to_os_string();
+    file_name.push(format!(
+        ".tmp-{}-{}",
+        std::process::id(),
+        TMP_COUNTER.fetch_add(1, Ordering::Relaxed)
+    ));
+    path.with_file_name(file_name)
+}
+
 //Will return error if buffer.len > FIELD_SIZE. If buffer.len < FIELD_SIZE, padding 0s will be added
 pub fn read_field_element_from_buffer_with_padding(buffer: &[u8]) -> IoResult<FieldElement> {
     let buff_len = buffer.len();
@@ -64,12 +110,249 @@ pub fn read_field_element_from_u64(num: u64) -> FieldElement {
     FieldElement::from_repr(BigInteger768::from(num))
 }
 
+//*******************************Proof and vk serialization formats********************************
+
+/// Wire formats available for SCProof and SCVk.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum SerializationFormat {
+    /// Affine points with both coordinates: bigger, but no square root needed when reading.
+    Uncompressed,
+    /// Affine points with x coordinate only: smaller, but y must be recomputed when reading.
+    Compressed,
+}
+
+impl SerializationFormat {
+    pub fn from_u32(format: u32) -> Option<Self> {
+        match format {
+            0 => Some(SerializationFormat::Uncompressed),
+            1 => Some(SerializationFormat::Compressed),
+            _ => None,
+        }
+    }
+}
+
+const POINT_INFINITY_FLAG: u8 = 1 << 0;
+const POINT_Y_GREATEST_FLAG: u8 = 1 << 1;
+
+trait CompressedSerialization: Sized {
+    fn write_compressed<W: Write>(&self, writer: W) -> IoResult<()>;
+    fn read_compressed<R: Read>(reader: R) -> IoResult<Self>;
+}
+
+macro_rules! impl_compressed_serialization {
+    ($affine: ty, $base_field: ty) => {
+        impl CompressedSerialization for $affine {
+            fn write_compressed<W: Write>(&self, mut writer: W) -> IoResult<()> {
+                let mut flags = 0u8;
+                let mut x = self.x;
+                if self.infinity {
+                    flags |= POINT_INFINITY_FLAG;
+                    x = <$base_field>::zero();
+                } else if self.y > -self.y {
+                    flags |= POINT_Y_GREATEST_FLAG;
+                }
+                x.write(&mut writer)?;
+                flags.write(&mut writer)
+            }
+
+            /// Only canonical encodings are accepted, so that each point has a single one:
+            /// no unknown flags, and the point at infinity must have x = 0 and no y flag.
+            fn read_compressed<R: Read>(mut reader: R) -> IoResult<Self> {
+                let x = <$base_field>::read(&mut reader)?;
+                let flags = u8::read(&mut reader)?;
+                if flags & !(POINT_INFINITY_FLAG | POINT_Y_GREATEST_FLAG) != 0 {
+                    return Err(IoError::new(ErrorKind::InvalidData, "unknown compressed point flags"));
+                }
+                if flags & POINT_INFINITY_FLAG != 0 {
+                    if flags & POINT_Y_GREATEST_FLAG != 0 || !x.is_zero() {
+                        return Err(IoError::new(ErrorKind::InvalidData, "non canonical point at infinity"));
+                    }
+                    return Ok(<$affine as AffineCurve>::zero());
+                }
+                let point = <$affine>::get_point_from_x(x, flags & POINT_Y_GREATEST_FLAG != 0)
+                    .ok_or(IoError::new(ErrorKind::InvalidData, "invalid compressed point"))?;
+                if !point.is_in_correct_subgroup_assuming_on_curve() {
+                    return Err(IoError::new(ErrorKind::InvalidData, "point not in prime order subgroup"));
+                }
+                Ok(point)
+            }
+        }
+    };
+}
+
+impl_compressed_serialization!(G1Affine, Fq);
+impl_compressed_serialization!(G2Affine, Fq2);
+
+pub fn get_sc_proof_size(format: SerializationFormat) -> usize {
+    match format {
+        SerializationFormat::Uncompressed => GROTH_PROOF_SIZE,
+        SerializationFormat::Compressed => GROTH_PROOF_COMPRESSED_SIZE,
+    }
+}
+
+pub fn get_sc_vk_size(format: SerializationFormat) -> usize {
+    match format {
+        SerializationFormat::Uncompressed => VK_SIZE,
+        SerializationFormat::Compressed => VK_COMPRESSED_SIZE,
+    }
+}
+
+pub fn serialize_sc_proof<W: Write>(proof: &SCProof, format: SerializationFormat, mut writer: W) -> IoResult<()> {
+    match format {
+        SerializationFormat::Uncompressed => proof.write(writer),
+        SerializationFormat::Compressed => {
+            proof.a.write_compressed(&mut writer)?;
+            proof.b.write_compressed(&mut writer)?;
+            proof.c.write_compressed(&mut writer)
+        },
+    }
+}
+
+pub fn deserialize_sc_proof<R: Read>(mut reader: R, format: SerializationFormat) -> IoResult<SCProof> {
+    match format {
+        SerializationFormat::Uncompressed => SCProof::read(reader),
+        SerializationFormat::Compressed => {
+            let a = G1Affine::read_compressed(&mut reader)?;
+            let b = G2Affine::read_compressed(&mut reader)?;
+            let c = G1Affine::read_compressed(&mut reader)?;
+            Ok(SCProof { a, b, c })
+        },
+    }
+}
+
+pub fn serialize_sc_vk<W: Write>(vk: &SCVk, format: SerializationFormat, mut writer: W) -> IoResult<()> {
+    match format {
+        SerializationFormat::Uncompressed => vk.write(writer),
+        SerializationFormat::Compressed => {
+            vk.alpha_g1_beta_g2.write(&mut writer)?;
+            vk.gamma_g2.write_compressed(&mut writer)?;
+            vk.delta_g2.write_compressed(&mut writer)?;
+            (vk.gamma_abc_g1.len() as u32).write(&mut writer)?;
+            for g in vk.gamma_abc_g1.iter() {
+                g.write_compressed(&mut writer)?;
+            }
+            Ok(())
+        },
+    }
+}
+
+pub fn deserialize_sc_vk<R: Read>(mut reader: R, format: SerializationFormat) -> IoResult<SCVk> {
+    match format {
+        SerializationFormat::Uncompressed => SCVk::read(reader),
+        SerializationFormat::Compressed => {
+            let alpha_g1_beta_g2 = FromBytes::read(&mut reader)?;
+            let gamma_g2 = G2Affine::read_compressed(&mut reader)?;
+            let delta_g2 = G2Affine::read_compressed(&mut reader)?;
+            let gamma_abc_g1_len = u32::read(&mut reader)? as usize;
+            let mut gamma_abc_g1 = vec![];
+            for _ in 0..gamma_abc_g1_len {
+                gamma_abc_g1.push(G1Affine::read_compressed(&mut reader)?);
+            }
+            Ok(SCVk { alpha_g1_beta_g2, gamma_g2, delta_g2, gamma_abc_g1 })
+        },
+    }
+}
+
+/// Deserialize the items of `item_size` bytes laid out contiguously in `bytes`, in parallel.
+/// Either all of them are deserialized, or an error is returned.
+fn deserialize_many<T, F>(bytes: &[u8], item_size: usize, read_item: F) -> IoResult<Vec<T>>
+where
+    T: Send,
+    F: Fn(&[u8]) -> IoResult<T> + Sync,
+{
+    if item_size == 0 || bytes.len() % item_size != 0 {
+        return Err(IoError::new(ErrorKind::InvalidInput, "unexpected size for serialized items"));
+    }
+    bytes.par_chunks(item_size).map(read_item).collect()
+}
+
+pub fn deserialize_sc_proofs(bytes: &[u8], format: SerializationFormat) -> IoResult<Vec<SCProof>> {
+    deserialize_many(bytes, get_sc_proof_size(format), |proof_bytes| deserialize_sc_proof(proof_bytes, format))
+}
+
+pub fn deserialize_sc_vks(bytes: &[u8], format: SerializationFormat) -> IoResult<Vec<SCVk>> {
+    deserialize_many(bytes, get_sc_vk_size(format), |vk_bytes| deserialize_sc_vk(vk_bytes, format))
+}
+
 //************************************Poseidon Hash function****************************************
 
 pub fn compute_poseidon_hash(input: &[FieldElement]) -> Result<FieldElement, Error> {
     FieldHash::evaluate(input)
 }
 
+// Named wrappers of compute_poseidon_hash() for the fixed-arity hashes used across the
+// crate. They pass their inputs as a stack array, and otherwise hash exactly like it:
+// FieldHash exposes no fixed-arity permutation to specialize on.
+
+/// Hash of a Merkle internal node, as computed by GingerMerkleTree. The trees handed out
+/// through FFI, and the streaming BT root, compute their nodes with it.
+pub fn compute_merkle_node_hash(left: &FieldElement, right: &FieldElement) -> Result<FieldElement, Error> {
+    compute_poseidon_hash(&[*left, *right])
+}
+
+pub fn compute_wcert_sysdata_hash(
+    quality: &FieldElement,
+    bt_root: &FieldElement,
+    prev_end_epoch_mc_b_hash: &FieldElement,
+    end_epoch_mc_b_hash: &FieldElement,
+) -> Result<FieldElement, Error> {
+    compute_poseidon_hash(&[*quality, *bt_root, *prev_end_epoch_mc_b_hash, *end_epoch_mc_b_hash])
+}
+
+/// Hash of the SC proof public inputs: `constant` and `proofdata`, if present, followed by
+/// `wcert_sysdata_hash`.
+pub fn compute_aggregated_input_hash(
+    constant: Option<&FieldElement>,
+    proofdata: Option<&FieldElement>,
+    wcert_sysdata_hash: &FieldElement,
+) -> Result<FieldElement, Error> {
+    match (constant, proofdata) {
+        (Some(constant), Some(proofdata)) => compute_poseidon_hash(&[*constant, *proofdata, *wcert_sysdata_hash]),
+        (Some(input), None) | (None, Some(input)) => compute_poseidon_hash(&[*input, *wcert_sysdata_hash]),
+        (None, None) => compute_poseidon_hash(&[*wcert_sysdata_hash]),
+    }
+}
+
+// Number of bytes that always fit a field element, without reduction
+pub const POSEIDON_BYTES_CHUNK_SIZE: usize = 94;
+
+/// Buffer of Poseidon inputs, which can be added one at a time, from different sources.
+/// It's not a sponge: `FieldHash` only exposes a one-shot evaluation, so the inputs are kept
+/// until `hash()`, which is the same as `compute_poseidon_hash()` on all of them. Memory grows
+/// with the inputs, and hashing a clone hashes again all the inputs it copied.
+#[derive(Clone, Default)]
+pub struct PoseidonInputs {
+    inputs: Vec<FieldElement>,
+}
+
+impl PoseidonInputs {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn add(&mut self, input: FieldElement) {
+        self.inputs.push(input);
+    }
+
+    /// Add `bytes` as a sequence of field elements, each one read from a chunk of
+    /// POSEIDON_BYTES_CHUNK_SIZE bytes (the last chunk is padded with zeros).
+    pub fn add_bytes(&mut self, bytes: &[u8]) -> IoResult<()> {
+        for chunk in bytes.chunks(POSEIDON_BYTES_CHUNK_SIZE) {
+            self.inputs.push(read_field_element_from_buffer_with_padding(chunk)?);
+        }
+        Ok(())
+    }
+
+    pub fn hash(&self) -> Result<FieldElement, Error> {
+        compute_poseidon_hash(self.inputs.as_slice())
+    }
+
+    /// Number of field elements added so far
+    pub fn len(&self) -> usize {
+        self.inputs.len()
+    }
+}
+
 //*****************************Naive threshold sig circuit related functions************************
 pub type SCProof = Proof<PairingCurve>;
 pub type SCVk = VerifyingKey<PairingCurve>;
@@ -84,24 +367,153 @@ impl BackwardTransfer {
     }
 }
 
+#[cfg(feature = "mc-test-circuit")]
+const TEST_MC_PK_FILE: &str = "test_mc_pk";
+
+#[cfg(feature = "mc-test-circuit")]
+const TEST_MC_VK_FILE: &str = "test_mc_vk";
+
+/// Bump this every time MCTestCircuit changes, in order to invalidate the cached parameters
+#[cfg(feature = "mc-test-circuit")]
+const TEST_MC_PARAMS_VERSION: u64 = 1;
+
+#[cfg(feature = "mc-test-circuit")]
+fn write_test_mc_parameters(
+    params: &proof_systems::groth16::Parameters<PairingCurve>,
+    params_dir: &Path,
+) -> Result<(), Error>
+{
+    write_to_file(params, &params_dir.join(TEST_MC_PK_FILE))?;
+    write_to_file(&params.vk, &params_dir.join(TEST_MC_VK_FILE))?;
+    Ok(())
+}
+
 #[cfg(feature = "mc-test-circuit")]
 pub fn generate_test_mc_parameters(params_dir: &Path) -> Result<(), Error>
 {
+    let params = MCTestCircuit::<FieldElement>::generate_parameters()?;
+
     //Save params to file
-    let pk_path = params_dir.join("test_mc_pk");
-    let vk_path = params_dir.join("test_mc_vk");
+    write_test_mc_parameters(&params, params_dir)
+}
 
-    let params = MCTestCircuit::<FieldElement>::generate_parameters()?;
+/// Generate the parameters from `seed` into `entry_dir`, checking that they have been
+/// written correctly and that they are durable on disk.
+#[cfg(feature = "mc-test-circuit")]
+fn write_test_mc_parameters_cache_entry(seed: &[u8; 32], entry_dir: &Path) -> Result<(), Error>
+{
+    fs::create_dir_all(entry_dir)?;
 
-    let mut fs_pk = File::create(pk_path)?;
-    params.clone().write(&mut fs_pk)?;
+    let params = MCTestCircuit::<FieldElement>::generate_parameters_from_seed(*seed)?;
+    write_test_mc_parameters(&params, entry_dir)?;
 
-    let mut fs_vk = File::create(vk_path)?;
-    params.vk.write(&mut fs_vk)?;
+    for file in [TEST_MC_PK_FILE, TEST_MC_VK_FILE].iter() {
+        fs::OpenOptions::new().write(true).open(entry_dir.join(file))?.sync_all()?;
+    }
+
+    let vk: SCVk = read_from_file(&entry_dir.join(TEST_MC_VK_FILE))?;
+    if vk != params.vk {
+        return Err("Unable to validate the generated MCTestCircuit parameters".into());
+    }
 
     Ok(())
 }
 
+/// Return the name of the cache entry holding the MCTestCircuit parameters generated from `seed`.
+/// The name is derived from the Poseidon hash of the seed and of the circuit version, so
+/// the same (circuit, seed) pair always maps to the same entry.
+#[cfg(feature = "mc-test-circuit")]
+pub fn get_test_mc_parameters_cache_key(seed: &[u8; 32]) -> Result<String, Error>
+{
+    let digest = compute_poseidon_hash(&[
+        read_field_element_from_u64(TEST_MC_PARAMS_VERSION),
+        read_field_element_from_buffer_with_padding(&seed[..])?,
+    ])?;
+
+    let mut digest_bytes = [0u8; FIELD_SIZE];
+    serialize_to_buffer(&digest, &mut digest_bytes[..])?;
+
+    Ok(digest_bytes[..32].iter().map(|b| format!("{:02x}", b)).collect())
+}
+
+/// Generate the MCTestCircuit parameters deterministically from `seed` and save them in `params_dir`.
+/// If `cache_dir` is specified, parameters already generated from the same seed are copied
+/// from there instead of running the setup again; otherwise, freshly generated parameters are
+/// validated and stored in `cache_dir` for the next calls.
+#[cfg(feature = "mc-test-circuit")]
+pub fn generate_test_mc_parameters_from_seed(
+    params_dir: &Path,
+    seed: &[u8; 32],
+    cache_dir: Option<&Path>,
+) -> Result<(), Error>
+{
+    let cache_dir = match cache_dir {
+        Some(cache_dir) => cache_dir,
+        None => {
+            let params = MCTestCircuit::<FieldElement>::generate_parameters_from_seed(*seed)?;
+            return write_test_mc_parameters(&params, params_dir);
+        }
+    };
+
+    let entry_dir = cache_dir.join(get_test_mc_parameters_cache_key(seed)?);
+
+    // Cache miss: generate the parameters in a temporary entry, check them, and only
+    // then publish the entry with an atomic rename, so that a present entry is always complete.
+    if !entry_dir.is_dir() {
+        let tmp_dir = get_tmp_path(&entry_dir);
+        let written = write_test_mc_parameters_cache_entry(seed, &tmp_dir);
+        if written.is_err() {
+            let _ = fs::remove_dir_all(&tmp_dir);
+        }
+        written?;
+
+        // Another process may have published the same entry in the meantime: ours is redundant
+        if fs::rename(&tmp_dir, &entry_dir).is_err() {
+            fs::remove_dir_all(&tmp_dir)?;
+        }
+    }
+
+    // Cache hit: plain file copies, no setup and no (de)serialization involved
+    if entry_dir != params_dir {
+        fs::create_dir_all(params_dir)?;
+        for file in [TEST_MC_PK_FILE, TEST_MC_VK_FILE].iter() {
+            fs::copy(entry_dir.join(file), params_dir.join(file))?;
+        }
+    }
+
+    Ok(())
+}
+
+#[cfg(feature = "mc-test-circuit")]
+lazy_static! {
+    static ref TEST_PROVER_POOL: Mutex<Option<Arc<ThreadPool>>> = Mutex::new(None);
+}
+
+/// Run `f` on a pool of `num_threads` threads, or on the global one if `num_threads` is 0.
+/// Only the last pool built is kept, and it's rebuilt when `num_threads` changes: calls
+/// still running on the previous one keep it alive until they complete.
+#[cfg(feature = "mc-test-circuit")]
+pub fn run_on_test_prover_pool<R, F>(num_threads: usize, f: F) -> Result<R, Error>
+where
+    R: Send,
+    F: FnOnce() -> R + Send,
+{
+    if num_threads == 0 {
+        return Ok(f());
+    }
+    let pool = {
+        let mut cached_pool = TEST_PROVER_POOL.lock().unwrap();
+        match cached_pool.as_ref() {
+            Some(pool) if pool.current_num_threads() == num_threads => pool.clone(),
+            _ => {
+                let pool = Arc::new(rayon::ThreadPoolBuilder::new().num_threads(num_threads).build()?);
+                *cached_pool = Some(pool.clone());
+                pool
+            }
+        }
+    };
+    Ok(pool.install(f))
+}
 
 #[cfg(feature = "mc-test-circuit")]
 pub fn create_test_mc_proof(
@@ -112,6 +524,7 @@ pub fn create_test_mc_proof(
     constant: &FieldElement,
     pk_path: &Path,
     proof_path: &Path,
+    num_threads: usize,
 ) -> Result<(), Error> {
 
     //Read inputs as field elements
@@ -123,32 +536,53 @@ pub fn create_test_mc_proof(
 
     let params = read_from_file(pk_path)?;
 
-    // Save proof to file
-    let proof = MCTestCircuit::<FieldElement>::create_proof(
+    //Create the proof: the parallel iterators of the prover (algebra and proof-systems
+    //share our rayon) run on the pool they are called from
+    let proof = run_on_test_prover_pool(num_threads, || MCTestCircuit::<FieldElement>::create_proof(
         end_epoch_mc_b_hash, prev_end_epoch_mc_b_hash, bt_root,
         quality, *constant, params
-    )?;
+    ))??;
+
+    // Save proof to file
 
-    let mut fs_proof = File::create(proof_path)?;
-    proof.write(&mut fs_proof)?;
+    write_to_file(&proof, proof_path)?;
 
     Ok(())
 }
 
 pub fn get_bt_merkle_root(bt_list: &[BackwardTransfer]) -> Result<FieldElement, Error>
 {
-    let bt_root = if bt_list.len() > 0 {
-        let mut bt_as_fes = vec![];
-        for bt in bt_list.iter() {
-            let bt_as_fe = bt.to_field_element()?;
-            bt_as_fes.push(bt_as_fe);
-        }
-        //Get Merkle Root of Backward Transfer list
-        let bt_tree = new_ginger_merkle_tree(bt_as_fes.as_slice())?;
-        get_ginger_merkle_root(&bt_tree)
-    } else { MNT4753_PHANTOM_MERKLE_ROOT };
+    //Get Merkle Root of Backward Transfer list, streaming the BTs instead of building the tree
+    let mut calculator = GingerMerkleRootCalculator::new();
+    for bt in bt_list.iter() {
+        calculator.append_bt(bt)?;
+    }
+    calculator.root()
+}
 
-    Ok(bt_root)
+/// Compute the public input of a SCProof, from the data of the certificate it refers to.
+pub fn get_sc_proof_public_input(
+    end_epoch_mc_b_hash: &[u8; 32],
+    prev_end_epoch_mc_b_hash: &[u8; 32],
+    bt_root: FieldElement,
+    quality: u64,
+    constant: Option<&FieldElement>,
+    proofdata: Option<&FieldElement>,
+) -> Result<FieldElement, Error> {
+    //Read inputs as field elements
+    let end_epoch_mc_b_hash = read_field_element_from_buffer_with_padding(end_epoch_mc_b_hash)?;
+    let prev_end_epoch_mc_b_hash =
+        read_field_element_from_buffer_with_padding(prev_end_epoch_mc_b_hash)?;
+    let quality = read_field_element_from_u64(quality);
+
+    let wcert_sysdata_hash = compute_wcert_sysdata_hash(
+        &quality,
+        &bt_root,
+        &prev_end_epoch_mc_b_hash,
+        &end_epoch_mc_b_hash,
+    )?;
+
+    compute_aggregated_input_hash(constant, proofdata, &wcert_sysdata_hash)
 }
 
 pub fn verify_sc_proof(
@@ -161,40 +595,152 @@ pub fn verify_sc_proof(
     sc_proof: &SCProof,
     vk: &SCVk,
 ) -> Result<bool, Error> {
-    //Read inputs as field elements
-    let end_epoch_mc_b_hash = read_field_element_from_buffer_with_padding(end_epoch_mc_b_hash)?;
-    let prev_end_epoch_mc_b_hash =
-        read_field_element_from_buffer_with_padding(prev_end_epoch_mc_b_hash)?;
-    let quality = read_field_element_from_u64(quality);
     let bt_root = get_bt_merkle_root(bt_list)?;
 
     //Load vk from file
     let pvk = prepare_verifying_key(&vk);
 
-    //Prepare public inputs
-    let mut public_inputs = Vec::new();
-
-    let wcert_sysdata_hash = compute_poseidon_hash(&[
-        quality,
-        bt_root,
-        prev_end_epoch_mc_b_hash,
+    let aggregated_inputs = get_sc_proof_public_input(
         end_epoch_mc_b_hash,
-    ])?;
+        prev_end_epoch_mc_b_hash,
+        bt_root,
+        quality,
+        constant,
+        proofdata,
+    )?;
 
-    if constant.is_some(){
-        public_inputs.push(*(constant.unwrap()));
+    //Verify proof
+    let is_verified = verify_proof(&pvk, &sc_proof, &[aggregated_inputs])?;
+    Ok(is_verified)
+}
+
+//*****************************Interruptible verification*****************************************
+
+/// Flag that can be raised from any thread to stop the verifications checking it.
+#[derive(Debug, Default)]
+pub struct CancellationToken(AtomicBool);
+
+impl CancellationToken {
+    pub fn new() -> Self {
+        Self::default()
     }
-    if proofdata.is_some(){
-        public_inputs.push(*(proofdata.unwrap()));
+
+    pub fn cancel(&self) {
+        self.0.store(true, Ordering::Relaxed);
     }
-    public_inputs.push(wcert_sysdata_hash);
 
-    let aggregated_inputs = compute_poseidon_hash(public_inputs.as_slice())?;
-    drop(public_inputs);
+    pub fn reset(&self) {
+        self.0.store(false, Ordering::Relaxed);
+    }
 
-    //Verify proof
-    let is_verified = verify_proof(&pvk, &sc_proof, &[aggregated_inputs])?;
-    Ok(is_verified)
+    pub fn is_cancelled(&self) -> bool {
+        self.0.load(Ordering::Relaxed)
+    }
+}
+
+/// Outcome of a verification which may be interrupted before completing.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum VerificationStatus {
+    Invalid = 0,
+    Valid = 1,
+    Cancelled = 2,
+    DeadlineExceeded = 3,
+    /// The verification couldn't be performed: only reported through FFI, alongside the error.
+    Error = 4,
+}
+
+/// Conditions under which a verification must be abandoned: they are checked
+/// between its stages.
+#[derive(Default)]
+pub struct VerificationInterrupt<'a> {
+    pub cancellation_token: Option<&'a CancellationToken>,
+    pub deadline:           Option<Instant>,
+}
+
+impl<'a> VerificationInterrupt<'a> {
+    pub fn check(&self) -> Option<VerificationStatus> {
+        if self.cancellation_token.map_or(false, |token| token.is_cancelled()) {
+            return Some(VerificationStatus::Cancelled);
+        }
+        if self.deadline.map_or(false, |deadline| Instant::now() >= deadline) {
+            return Some(VerificationStatus::DeadlineExceeded);
+        }
+        None
+    }
+}
+
+/// Same as `verify_sc_proof()`, but `interrupt` is checked before each stage of the verification
+/// (input hashing, BT root, preparation of the inputs, each of the three Miller loops and the final
+/// exponentiation), returning as soon as it's triggered. The Groth16 check is performed
+/// explicitly, as e(A, B) * e(inputs, -gamma) * e(C, -delta) == e(alpha, beta), in order to
+/// interrupt it between the pairings.
+pub fn verify_sc_proof_interruptible(
+    end_epoch_mc_b_hash: &[u8; 32],
+    prev_end_epoch_mc_b_hash: &[u8; 32],
+    bt_list: &[BackwardTransfer],
+    quality: u64,
+    constant: Option<&FieldElement>,
+    proofdata: Option<&FieldElement>,
+    sc_proof: &SCProof,
+    vk: &SCVk,
+    interrupt: &VerificationInterrupt,
+) -> Result<VerificationStatus, Error> {
+    type G1Prepared = <PairingCurve as PairingEngine>::G1Prepared;
+    type G2Prepared = <PairingCurve as PairingEngine>::G2Prepared;
+
+    macro_rules! check_interrupt {
+        () => {
+            if let Some(status) = interrupt.check() {
+                return Ok(status);
+            }
+        };
+    }
+
+    if vk.gamma_abc_g1.len() != 2 {
+        return Err("Malformed verifying key: exactly one public input expected".into());
+    }
+
+    check_interrupt!();
+    let bt_root = get_bt_merkle_root(bt_list)?;
+
+    check_interrupt!();
+    let aggregated_inputs = get_sc_proof_public_input(
+        end_epoch_mc_b_hash,
+        prev_end_epoch_mc_b_hash,
+        bt_root,
+        quality,
+        constant,
+        proofdata,
+    )?;
+
+    check_interrupt!();
+    let mut prepared_inputs = vk.gamma_abc_g1[0].into_projective();
+    prepared_inputs += &vk.gamma_abc_g1[1].mul(aggregated_inputs.into_repr());
+
+    check_interrupt!();
+    let a: G1Prepared = sc_proof.a.into();
+    let b: G2Prepared = sc_proof.b.into();
+    let mut qap = PairingCurve::miller_loop(&[(a, b)]);
+
+    check_interrupt!();
+    let inputs: G1Prepared = prepared_inputs.into_affine().into();
+    let gamma_neg: G2Prepared = (-vk.gamma_g2).into();
+    qap *= &PairingCurve::miller_loop(&[(inputs, gamma_neg)]);
+
+    check_interrupt!();
+    let c: G1Prepared = sc_proof.c.into();
+    let delta_neg: G2Prepared = (-vk.delta_g2).into();
+    qap *= &PairingCurve::miller_loop(&[(c, delta_neg)]);
+
+    check_interrupt!();
+    let test = PairingCurve::final_exponentiation(&qap)
+        .ok_or("Unexpected identity in final exponentiation")?;
+
+    if test == vk.alpha_g1_beta_g2 {
+        Ok(VerificationStatus::Valid)
+    } else {
+        Ok(VerificationStatus::Invalid)
+    }
 }
 
 //************Merkle Tree functions******************
@@ -213,6 +759,143 @@ pub fn new_ginger_merkle_tree(leaves: &[FieldElement]) -> Result<GingerMerkleTre
     GingerMerkleTree::new(leaves)
 }
 
+/// Number of nodes stored for a GingerMerkleTree built on `leaves_len` leaves: all the nodes of
+/// the smallest complete tree containing the leaves, plus one node for each level above it.
+pub fn merkle_tree_nodes_len(leaves_len: usize) -> usize {
+    let complete_leaves = leaves_len.next_power_of_two();
+    let complete_height = complete_leaves.trailing_zeros() as usize;
+    2 * complete_leaves - 1 + (MERKLE_TREE_HEIGHT - 1).saturating_sub(complete_height)
+}
+
+/// Memory held by an in-memory GingerMerkleTree built on `leaves_len` leaves.
+pub fn merkle_tree_heap_size(leaves_len: usize) -> usize {
+    std::mem::size_of::<GingerMerkleTreeHandle>() + merkle_tree_nodes_len(leaves_len) * std::mem::size_of::<FieldElement>()
+}
+
+/// Nodes of a GingerMerkleTree, indexed level by level starting from the leaves: first all the
+/// levels of the smallest complete tree containing the leaves (padded with empty leaves), then
+/// one node for each level above it, up to the root. Merkle paths are read from the siblings
+/// of the nodes, without any hashing.
+pub trait GingerMerkleTreeNodes {
+    fn leaves_len(&self) -> usize;
+
+    fn node(&self, index: usize) -> IoResult<FieldElement>;
+
+    fn root(&self) -> IoResult<FieldElement> {
+        self.node(merkle_tree_nodes_len(self.leaves_len()) - 1)
+    }
+
+    /// Return the Merkle path of the leaf at `leaf_index`, checking that it's `leaf`.
+    fn merkle_path(&self, leaf: &FieldElement, leaf_index: usize) -> Result<GingerMerkleTreePath, Error> {
+        if leaf_index >= self.leaves_len() {
+            return Err(IoError::new(ErrorKind::InvalidInput, "leaf index out of bounds").into());
+        }
+        if self.node(leaf_index)? != *leaf {
+            return Err(IoError::new(ErrorKind::InvalidInput, "leaf doesn't match the one at the specified index").into());
+        }
+        let padding = &*GINGER_MERKLE_PADDING;
+
+        //Siblings inside the complete tree
+        let mut path = Vec::with_capacity(MERKLE_TREE_HEIGHT - 1);
+        let mut level_start = 0;
+        let mut level_len = self.leaves_len().next_power_of_two();
+        let mut index = leaf_index;
+        while level_len > 1 {
+            let sibling = self.node(level_start + (index ^ 1))?;
+            path.push((sibling, padding.path_direction(index % 2 == 0)));
+            level_start += level_len;
+            level_len /= 2;
+            index /= 2;
+        }
+
+        //Siblings above it
+        for level in path.len()..MERKLE_TREE_HEIGHT - 1 {
+            path.push((padding.siblings[level], padding.path_direction(true)));
+        }
+
+        Ok(GingerMerkleTreePath { path })
+    }
+}
+
+/// A GingerMerkleTree whose nodes are all held in memory.
+pub struct InMemoryGingerMerkleTree {
+    nodes:      Vec<FieldElement>,
+    leaves_len: usize,
+}
+
+impl InMemoryGingerMerkleTree {
+    /// Compute all the nodes of the tree built on `leaves`: they are the same of a
+    /// GingerMerkleTree built on them.
+    pub fn new(leaves: &[FieldElement]) -> Result<Self, Error> {
+        if leaves.len() > GingerMerkleRootCalculator::MAX_LEAVES {
+            return Err(IoError::new(ErrorKind::InvalidInput, "too many leaves for a Merkle tree").into());
+        }
+        //An empty tree is accepted only if GingerMerkleTree accepts it too
+        if leaves.is_empty() {
+            new_ginger_merkle_tree(leaves)?;
+        }
+        let padding = &*GINGER_MERKLE_PADDING;
+
+        //Leaves, padded to the next power of two
+        let mut level_len = leaves.len().next_power_of_two();
+        let mut nodes = Vec::with_capacity(merkle_tree_nodes_len(leaves.len()));
+        nodes.extend_from_slice(leaves);
+        nodes.resize(level_len, padding.empty_subtrees[0]);
+
+        //Levels of the complete tree: subtrees made of padding leaves only are known in advance
+        let mut level_start = 0;
+        let mut level = 0;
+        while level_len > 1 {
+            level += 1;
+            for i in 0..level_len / 2 {
+                let node = if (i << level) >= leaves.len() {
+                    padding.empty_subtrees[level]
+                } else {
+                    compute_merkle_node_hash(&nodes[level_start + 2 * i], &nodes[level_start + 2 * i + 1])?
+                };
+                nodes.push(node);
+            }
+            level_start += level_len;
+            level_len /= 2;
+        }
+
+        //Levels above it, up to the root
+        let mut node = nodes[nodes.len() - 1];
+        for level in level..MERKLE_TREE_HEIGHT - 1 {
+            node = compute_merkle_node_hash(&node, &padding.siblings[level])?;
+            nodes.push(node);
+        }
+
+        Ok(Self { nodes, leaves_len: leaves.len() })
+    }
+}
+
+impl GingerMerkleTreeNodes for InMemoryGingerMerkleTree {
+    fn leaves_len(&self) -> usize {
+        self.leaves_len
+    }
+
+    fn node(&self, index: usize) -> IoResult<FieldElement> {
+        self.nodes.get(index).cloned()
+            .ok_or(IoError::new(ErrorKind::InvalidInput, "node index out of bounds"))
+    }
+}
+
+/// A GingerMerkleTree, as handed out through FFI: either held in memory, or memory mapped from a file.
+pub enum GingerMerkleTreeHandle {
+    InMemory(InMemoryGingerMerkleTree),
+    Persistent(PersistentGingerMerkleTree),
+}
+
+impl GingerMerkleTreeHandle {
+    pub fn nodes(&self) -> &dyn GingerMerkleTreeNodes {
+        match self {
+            GingerMerkleTreeHandle::InMemory(tree) => tree,
+            GingerMerkleTreeHandle::Persistent(tree) => tree,
+        }
+    }
+}
+
 pub fn get_ginger_merkle_root(tree: &GingerMerkleTree) -> FieldElement {
     tree.root()
 }
@@ -232,3 +915,118 @@ pub fn verify_ginger_merkle_path(
 ) -> Result<bool, Error> {
     path.verify(merkle_root, leaf)
 }
+
+const MERKLE_TREE_HEIGHT: usize = FieldBasedMerkleTreeParams::HEIGHT;
+
+/// Nodes needed to complete a GingerMerkleTree whose leaves are not a power of two, and to
+/// pad it up to HEIGHT.
+struct GingerMerklePadding {
+    /// `empty_subtrees[i]` is the root of a subtree of 2^i empty leaves.
+    empty_subtrees: Vec<FieldElement>,
+    /// `siblings[i]` is the sibling hashed with a node at level i when padding the tree above it.
+    siblings:       Vec<FieldElement>,
+    /// Direction of a GingerMerkleTreePath step in which the current node is the left child.
+    left_direction: bool,
+}
+
+impl GingerMerklePadding {
+    /// The padding nodes are the ones found in the Merkle path of a tree with a single leaf:
+    /// taking them from a reference tree keeps them consistent with GingerMerkleTree.
+    fn new() -> Result<Self, Error> {
+        let leaf = read_field_element_from_u64(0);
+        let reference_path = GingerMerkleTree::new(&[leaf])?.generate_proof(0, &leaf)?;
+        let siblings: Vec<FieldElement> = reference_path.path.iter().map(|(sibling, _)| *sibling).collect();
+
+        let mut empty_subtrees = Vec::with_capacity(MERKLE_TREE_HEIGHT);
+        empty_subtrees.push(siblings[0]);
+        for i in 1..MERKLE_TREE_HEIGHT {
+            let node = compute_merkle_node_hash(&empty_subtrees[i - 1], &empty_subtrees[i - 1])?;
+            empty_subtrees.push(node);
+        }
+
+        Ok(Self { empty_subtrees, siblings, left_direction: reference_path.path[0].1 })
+    }
+
+    fn path_direction(&self, is_left: bool) -> bool {
+        if is_left { self.left_direction } else { !self.left_direction }
+    }
+}
+
+lazy_static! {
+    static ref GINGER_MERKLE_PADDING: GingerMerklePadding = GingerMerklePadding::new()
+        .expect("unable to compute Merkle tree padding");
+}
+
+/// Computes the root of the GingerMerkleTree built on a sequence of leaves, appended one at
+/// a time, without building the tree: only one pending node per level is kept.
+#[derive(Clone)]
+pub struct GingerMerkleRootCalculator {
+    /// `pending[i]` is the root of the last complete subtree of 2^i leaves, if still waiting
+    /// for its right sibling.
+    pending:    [Option<FieldElement>; MERKLE_TREE_HEIGHT],
+    leaves_len: usize,
+}
+
+impl GingerMerkleRootCalculator {
+    /// Max number of leaves of a GingerMerkleTree
+    pub const MAX_LEAVES: usize = 1 << (MERKLE_TREE_HEIGHT - 1);
+
+    pub fn new() -> Self {
+        Self { pending: [None; MERKLE_TREE_HEIGHT], leaves_len: 0 }
+    }
+
+    pub fn append(&mut self, leaf: FieldElement) -> Result<(), Error> {
+        if self.leaves_len == Self::MAX_LEAVES {
+            return Err(IoError::new(ErrorKind::InvalidInput, "too many leaves for a Merkle tree").into());
+        }
+
+        let mut node = leaf;
+        let mut level = 0;
+        while let Some(left) = self.pending[level].take() {
+            node = compute_merkle_node_hash(&left, &node)?;
+            level += 1;
+        }
+        self.pending[level] = Some(node);
+        self.leaves_len += 1;
+        Ok(())
+    }
+
+    pub fn append_bt(&mut self, bt: &BackwardTransfer) -> Result<(), Error> {
+        self.append(bt.to_field_element()?)
+    }
+
+    pub fn leaves_len(&self) -> usize {
+        self.leaves_len
+    }
+
+    /// Return the root of the tree built on the leaves appended so far,
+    /// or MNT4753_PHANTOM_MERKLE_ROOT if there aren't any.
+    pub fn root(&self) -> Result<FieldElement, Error> {
+        if self.leaves_len == 0 {
+            return Ok(MNT4753_PHANTOM_MERKLE_ROOT);
+        }
+        let padding = &*GINGER_MERKLE_PADDING;
+
+        //Complete the smallest complete tree containing the leaves, filling it with empty subtrees
+        let complete_height = self.leaves_len.next_power_of_two().trailing_zeros() as usize;
+        let mut node: Option<FieldElement> = None;
+        for level in 0..complete_height {
+            node = match (self.pending[level], node) {
+                (Some(left), Some(right)) => Some(compute_merkle_node_hash(&left, &right)?),
+                (Some(left), None) => Some(compute_merkle_node_hash(&left, &padding.empty_subtrees[level])?),
+                (None, Some(left)) => Some(compute_merkle_node_hash(&left, &padding.empty_subtrees[level])?),
+                (None, None) => None,
+            };
+        }
+        let mut node = match node {
+            Some(node) => node,
+            None => self.pending[complete_height].unwrap(),
+        };
+
+        //Pad it up to HEIGHT
+        for level in complete_height..MERKLE_TREE_HEIGHT - 1 {
+            node = compute_merkle_node_hash(&node, &padding.siblings[level])?;
+        }
+        Ok(node)
+    }
+}
@@ -3,10 +3,12 @@ use libc::{c_uchar, c_uint};
 use rand::rngs::OsRng;
 use std::{
     io::{Error as IoError, ErrorKind},
+    mem::size_of,
     path::Path,
     ptr::null_mut,
     any::type_name,
     slice,
+    time::{Duration, Instant},
 };
 
 pub mod error;
@@ -15,6 +17,12 @@ use error::*;
 pub mod ginger_calls;
 use ginger_calls::*;
 
+pub mod memory;
+use memory::*;
+
+pub mod persistent_mht;
+use persistent_mht::PersistentGingerMerkleTree;
+
 #[cfg(test)]
 pub mod tests;
 
@@ -57,9 +65,49 @@ fn read_double_raw_pointer<T: Copy>(
     input
 }
 
-fn deserialize_to_raw_pointer<T: FromBytes>(buffer: &[u8]) -> *mut T {
+/// Hand out `t` through FFI, accounting the memory it holds. Return NULL, setting
+/// the last error, if this would exceed the memory budget.
+fn into_tracked_raw_pointer<T: TrackedObject>(t: T) -> *mut T {
+    match MEMORY_TRACKER.track(T::KIND, t.heap_size()) {
+        Ok(()) => Box::into_raw(Box::new(t)),
+        Err(e) => {
+            set_last_error(Box::new(e), MEMORY_ERROR);
+            null_mut()
+        }
+    }
+}
+
+fn free_tracked_raw_pointer<T: TrackedObject>(ptr: *mut T) {
+    if ptr.is_null() {
+        return;
+    }
+    let t = unsafe { Box::from_raw(ptr) };
+    MEMORY_TRACKER.untrack(T::KIND, t.heap_size());
+    drop(t);
+}
+
+/// Hand out all `items` through `out`, which must have room for them: either all of
+/// them are handed out, or none is (and false is returned).
+fn into_tracked_raw_pointers<T: TrackedObject>(items: Vec<T>, out: *mut *mut T) -> bool {
+    assert!(!out.is_null());
+    let out = unsafe { slice::from_raw_parts_mut(out, items.len()) };
+
+    for (i, item) in items.into_iter().enumerate() {
+        out[i] = into_tracked_raw_pointer(item);
+        if out[i].is_null() {
+            for ptr in out[..i].iter_mut() {
+                free_tracked_raw_pointer(*ptr);
+                *ptr = null_mut();
+            }
+            return false;
+        }
+    }
+    true
+}
+
+fn deserialize_to_raw_pointer<T: FromBytes + TrackedObject>(buffer: &[u8]) -> *mut T {
     match deserialize_from_buffer(buffer) {
-        Ok(t) => Box::into_raw(Box::new(t)),
+        Ok(t) => into_tracked_raw_pointer(t),
         Err(_) => {
             let e = IoError::new(
                 ErrorKind::InvalidData,
@@ -71,6 +119,42 @@ fn deserialize_to_raw_pointer<T: FromBytes>(buffer: &[u8]) -> *mut T {
     }
 }
 
+/// Report `code` through the nullable out-parameter `error_code` and, if it's an
+/// actual error, through `LAST_ERROR` too.
+fn set_error_code(error_code: *mut c_uint, code: u32) {
+    if code != ERROR_CODE_OK {
+        set_last_error_code(code);
+    }
+    if let Some(error_code) = unsafe { error_code.as_mut() } {
+        *error_code = code;
+    }
+}
+
+/// Like `deserialize_to_raw_pointer`, but reports failures as `failure_code` through
+/// `error_code` instead of formatting an error message.
+fn deserialize_to_raw_pointer_ex<T: FromBytes + TrackedObject>(
+    buffer: &[u8],
+    failure_code: u32,
+    error_code: *mut c_uint,
+) -> *mut T {
+    match deserialize_from_buffer::<T>(buffer) {
+        Ok(t) => match MEMORY_TRACKER.track(T::KIND, t.heap_size()) {
+            Ok(()) => {
+                set_error_code(error_code, ERROR_CODE_OK);
+                Box::into_raw(Box::new(t))
+            },
+            Err(_) => {
+                set_error_code(error_code, ERROR_CODE_MEMORY_BUDGET_EXCEEDED);
+                null_mut()
+            }
+        },
+        Err(_) => {
+            set_error_code(error_code, failure_code);
+            null_mut()
+        }
+    }
+}
+
 fn serialize_from_raw_pointer<T: ToBytes>(
     to_write: *const T,
     buffer: &mut [u8],
@@ -99,6 +183,63 @@ fn deserialize_from_file<T: FromBytes>(
     }
 }
 
+fn check_sized_buffer(is_null: bool, len: usize, expected_len: usize) -> bool {
+    if is_null || len != expected_len {
+        let e = IoError::new(
+            ErrorKind::InvalidInput,
+            format!("unexpected buffer size: expected {} bytes, found {}", expected_len, len),
+        );
+        set_last_error(Box::new(e), IO_ERROR);
+        return false;
+    }
+    true
+}
+
+/// Read the `len` bytes at `buffer`, checking that they are exactly `expected_len`.
+fn read_sized_buffer<'a>(buffer: *const c_uchar, len: usize, expected_len: usize) -> Option<&'a [u8]> {
+    if !check_sized_buffer(buffer.is_null(), len, expected_len) {
+        return None;
+    }
+    Some(unsafe { slice::from_raw_parts(buffer, len) })
+}
+
+/// Same as `read_sized_buffer()`, for a buffer to be written.
+fn read_sized_buffer_mut<'a>(buffer: *mut c_uchar, len: usize, expected_len: usize) -> Option<&'a mut [u8]> {
+    if !check_sized_buffer(buffer.is_null(), len, expected_len) {
+        return None;
+    }
+    Some(unsafe { slice::from_raw_parts_mut(buffer, len) })
+}
+
+/// Read the bytes of `items_len` serialized items of `item_size` bytes each, at `buffer`,
+/// checking that both `buffer` and `out` (where the items will be handed out) are not NULL.
+fn read_items_buffer<'a, T>(
+    buffer: *const c_uchar,
+    items_len: usize,
+    item_size: usize,
+    out: *mut *mut T,
+) -> Option<&'a [u8]> {
+    let e = if buffer.is_null() || out.is_null() {
+        IoError::new(ErrorKind::InvalidInput, "NULL buffer for a non-empty list of items")
+    } else {
+        match items_len.checked_mul(item_size) {
+            Some(len) => return Some(unsafe { slice::from_raw_parts(buffer, len) }),
+            None => IoError::new(ErrorKind::InvalidInput, "too many items"),
+        }
+    };
+    set_last_error(Box::new(e), IO_ERROR);
+    None
+}
+
+fn read_serialization_format(format: c_uint) -> Option<SerializationFormat> {
+    let format = SerializationFormat::from_u32(format);
+    if format.is_none() {
+        let e = IoError::new(ErrorKind::InvalidInput, "unknown serialization format");
+        set_last_error(Box::new(e), IO_ERROR);
+    }
+    format
+}
+
 //***********Field functions****************
 #[no_mangle]
 pub extern "C" fn zendoo_get_field_size_in_bytes() -> c_uint {
@@ -123,12 +264,21 @@ pub extern "C" fn zendoo_deserialize_field(
     deserialize_to_raw_pointer(&(unsafe { &*field_bytes })[..])
 }
 
+#[no_mangle]
+pub extern "C" fn zendoo_deserialize_field_ex(
+    field_bytes: *const [c_uchar; FIELD_SIZE],
+    error_code: *mut c_uint,
+) -> *mut FieldElement {
+    deserialize_to_raw_pointer_ex(
+        &(unsafe { &*field_bytes })[..],
+        ERROR_CODE_INVALID_FIELD,
+        error_code,
+    )
+}
+
 #[no_mangle]
 pub extern "C" fn zendoo_field_free(field: *mut FieldElement) {
-    if field.is_null() {
-        return;
-    }
-    drop(unsafe { Box::from_raw(field) });
+    free_tracked_raw_pointer(field)
 }
 
 //********************Sidechain SNARK functions********************
@@ -162,11 +312,109 @@ pub extern "C" fn zendoo_deserialize_sc_proof(
 }
 
 #[no_mangle]
-pub extern "C" fn zendoo_sc_proof_free(sc_proof: *mut SCProof) {
-    if sc_proof.is_null() {
-        return;
+pub extern "C" fn zendoo_deserialize_sc_proof_ex(
+    sc_proof_bytes: *const [c_uchar; GROTH_PROOF_SIZE],
+    error_code: *mut c_uint,
+) -> *mut SCProof {
+    deserialize_to_raw_pointer_ex(
+        &(unsafe { &*sc_proof_bytes })[..],
+        ERROR_CODE_INVALID_SC_PROOF,
+        error_code,
+    )
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_get_sc_proof_size_in_bytes_with_format(format: c_uint) -> usize {
+    match read_serialization_format(format) {
+        Some(format) => get_sc_proof_size(format),
+        None => 0,
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_serialize_sc_proof_with_format(
+    sc_proof: *const SCProof,
+    format: c_uint,
+    sc_proof_bytes: *mut c_uchar,
+    sc_proof_bytes_len: usize,
+) -> bool {
+    let format = match read_serialization_format(format) {
+        Some(format) => format,
+        None => return false,
+    };
+
+    let sc_proof_bytes = match read_sized_buffer_mut(sc_proof_bytes, sc_proof_bytes_len, get_sc_proof_size(format)) {
+        Some(bytes) => bytes,
+        None => return false,
+    };
+
+    match serialize_sc_proof(read_raw_pointer(sc_proof), format, sc_proof_bytes) {
+        Ok(()) => true,
+        Err(e) => {
+            set_last_error(Box::new(e), IO_ERROR);
+            false
+        }
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_deserialize_sc_proof_with_format(
+    sc_proof_bytes: *const c_uchar,
+    sc_proof_bytes_len: usize,
+    format: c_uint,
+) -> *mut SCProof {
+    let format = match read_serialization_format(format) {
+        Some(format) => format,
+        None => return null_mut(),
+    };
+
+    let sc_proof_bytes = match read_sized_buffer(sc_proof_bytes, sc_proof_bytes_len, get_sc_proof_size(format)) {
+        Some(sc_proof_bytes) => sc_proof_bytes,
+        None => return null_mut(),
+    };
+
+    match deserialize_sc_proof(sc_proof_bytes, format) {
+        Ok(sc_proof) => into_tracked_raw_pointer(sc_proof),
+        Err(e) => {
+            set_last_error(Box::new(e), IO_ERROR);
+            null_mut()
+        }
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_deserialize_sc_proofs(
+    sc_proofs_bytes: *const c_uchar,
+    sc_proofs_len: usize,
+    format: c_uint,
+    sc_proofs: *mut *mut SCProof,
+) -> bool {
+    let format = match read_serialization_format(format) {
+        Some(format) => format,
+        None => return false,
+    };
+
+    if sc_proofs_len == 0 {
+        return true;
+    }
+
+    let sc_proofs_bytes = match read_items_buffer(sc_proofs_bytes, sc_proofs_len, get_sc_proof_size(format), sc_proofs) {
+        Some(bytes) => bytes,
+        None => return false,
+    };
+
+    match deserialize_sc_proofs(sc_proofs_bytes, format) {
+        Ok(proofs) => into_tracked_raw_pointers(proofs, sc_proofs),
+        Err(e) => {
+            set_last_error(Box::new(e), IO_ERROR);
+            false
+        }
     }
-    drop(unsafe { Box::from_raw(sc_proof) });
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_sc_proof_free(sc_proof: *mut SCProof) {
+    free_tracked_raw_pointer(sc_proof)
 }
 
 #[no_mangle]
@@ -187,7 +435,7 @@ pub extern "C" fn zendoo_deserialize_sc_vk_from_file(
     }));
 
     match deserialize_from_file(vk_path){
-        Some(vk) => Box::into_raw(Box::new(vk)),
+        Some(vk) => into_tracked_raw_pointer(vk),
         None => null_mut(),
     }
 }
@@ -206,7 +454,7 @@ pub extern "C" fn zendoo_deserialize_sc_vk_from_file(
     let vk_path = Path::new(&path_str);
 
     match deserialize_from_file(vk_path){
-        Some(vk) => Box::into_raw(Box::new(vk)),
+        Some(vk) => into_tracked_raw_pointer(vk),
         None => null_mut(),
     }
 }
@@ -218,11 +466,134 @@ pub extern "C" fn zendoo_deserialize_sc_vk(
     deserialize_to_raw_pointer(&(unsafe { &*sc_vk_bytes })[..])
 }
 
+#[no_mangle]
+pub extern "C" fn zendoo_deserialize_sc_vk_ex(
+    sc_vk_bytes: *const [c_uchar; VK_SIZE],
+    error_code: *mut c_uint,
+) -> *mut SCVk {
+    deserialize_to_raw_pointer_ex(
+        &(unsafe { &*sc_vk_bytes })[..],
+        ERROR_CODE_INVALID_SC_VK,
+        error_code,
+    )
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_get_sc_vk_size_in_bytes_with_format(format: c_uint) -> usize {
+    match read_serialization_format(format) {
+        Some(format) => get_sc_vk_size(format),
+        None => 0,
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_serialize_sc_vk_with_format(
+    sc_vk: *const SCVk,
+    format: c_uint,
+    sc_vk_bytes: *mut c_uchar,
+    sc_vk_bytes_len: usize,
+) -> bool {
+    let format = match read_serialization_format(format) {
+        Some(format) => format,
+        None => return false,
+    };
+
+    let sc_vk_bytes = match read_sized_buffer_mut(sc_vk_bytes, sc_vk_bytes_len, get_sc_vk_size(format)) {
+        Some(bytes) => bytes,
+        None => return false,
+    };
+
+    match serialize_sc_vk(read_raw_pointer(sc_vk), format, sc_vk_bytes) {
+        Ok(()) => true,
+        Err(e) => {
+            set_last_error(Box::new(e), IO_ERROR);
+            false
+        }
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_deserialize_sc_vk_with_format(
+    sc_vk_bytes: *const c_uchar,
+    sc_vk_bytes_len: usize,
+    format: c_uint,
+) -> *mut SCVk {
+    let format = match read_serialization_format(format) {
+        Some(format) => format,
+        None => return null_mut(),
+    };
+
+    let sc_vk_bytes = match read_sized_buffer(sc_vk_bytes, sc_vk_bytes_len, get_sc_vk_size(format)) {
+        Some(sc_vk_bytes) => sc_vk_bytes,
+        None => return null_mut(),
+    };
+
+    match deserialize_sc_vk(sc_vk_bytes, format) {
+        Ok(sc_vk) => into_tracked_raw_pointer(sc_vk),
+        Err(e) => {
+            set_last_error(Box::new(e), IO_ERROR);
+            null_mut()
+        }
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_deserialize_sc_vks(
+    sc_vks_bytes: *const c_uchar,
+    sc_vks_len: usize,
+    format: c_uint,
+    sc_vks: *mut *mut SCVk,
+) -> bool {
+    let format = match read_serialization_format(format) {
+        Some(format) => format,
+        None => return false,
+    };
+
+    if sc_vks_len == 0 {
+        return true;
+    }
+
+    let sc_vks_bytes = match read_items_buffer(sc_vks_bytes, sc_vks_len, get_sc_vk_size(format), sc_vks) {
+        Some(bytes) => bytes,
+        None => return false,
+    };
+
+    match deserialize_sc_vks(sc_vks_bytes, format) {
+        Ok(vks) => into_tracked_raw_pointers(vks, sc_vks),
+        Err(e) => {
+            set_last_error(Box::new(e), IO_ERROR);
+            false
+        }
+    }
+}
+
 #[no_mangle]
 pub extern "C" fn zendoo_sc_vk_free(sc_vk: *mut SCVk)
 {
-    if sc_vk.is_null()  { return }
-    drop(unsafe { Box::from_raw(sc_vk) });
+    free_tracked_raw_pointer(sc_vk)
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_compute_bt_root_streaming(
+    bt_list: *const BackwardTransfer,
+    bt_list_len: usize,
+) -> *mut FieldElement {
+
+    //Read bt_list
+    let bt_list = if !bt_list.is_null() {
+        unsafe { slice::from_raw_parts(bt_list, bt_list_len) }
+    } else {
+        &[]
+    };
+
+    //Compute the root, consuming the BTs one at a time
+    match get_bt_merkle_root(bt_list) {
+        Ok(root) => into_tracked_raw_pointer(root),
+        Err(e) => {
+            set_last_error(e, CRYPTO_ERROR);
+            null_mut()
+        }
+    }
 }
 
 #[no_mangle]
@@ -282,6 +653,174 @@ pub extern "C" fn zendoo_verify_sc_proof(
     }
 }
 
+#[no_mangle]
+pub extern "C" fn zendoo_verify_sc_proof_ex(
+    end_epoch_mc_b_hash: *const [c_uchar; 32],
+    prev_end_epoch_mc_b_hash: *const [c_uchar; 32],
+    bt_list: *const BackwardTransfer,
+    bt_list_len: usize,
+    quality: u64,
+    constant: *const FieldElement,
+    proofdata: *const FieldElement,
+    sc_proof: *const SCProof,
+    vk:       *const SCVk,
+    error_code: *mut c_uint,
+) -> bool {
+
+    //Read end_epoch_mc_b_hash
+    let end_epoch_mc_b_hash = read_raw_pointer(end_epoch_mc_b_hash);
+
+    //Read prev_end_epoch_mc_b_hash
+    let prev_end_epoch_mc_b_hash = read_raw_pointer(prev_end_epoch_mc_b_hash);
+
+    //Read bt_list
+    let bt_list = if !bt_list.is_null() {
+        unsafe { slice::from_raw_parts(bt_list, bt_list_len) }
+    } else {
+        &[]
+    };
+
+    //Read constant
+    let constant = read_nullable_raw_pointer(constant);
+
+    //Read proofdata
+    let proofdata = read_nullable_raw_pointer(proofdata);
+
+    //Read SCProof
+    let sc_proof = read_raw_pointer(sc_proof);
+
+    //Read vk
+    let vk = read_raw_pointer(vk);
+
+    //Verify proof: a rejected proof is not an error, so it's reported as ERROR_CODE_OK
+    match ginger_calls::verify_sc_proof(
+        end_epoch_mc_b_hash,
+        prev_end_epoch_mc_b_hash,
+        bt_list,
+        quality,
+        constant,
+        proofdata,
+        sc_proof,
+        &vk,
+    ) {
+        Ok(result) => {
+            set_error_code(error_code, ERROR_CODE_OK);
+            result
+        },
+        Err(_) => {
+            set_error_code(error_code, ERROR_CODE_VERIFICATION_ERROR);
+            false
+        }
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_cancellation_token_new() -> *mut CancellationToken {
+    Box::into_raw(Box::new(CancellationToken::new()))
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_cancellation_token_cancel(token: *const CancellationToken) {
+    read_raw_pointer(token).cancel()
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_cancellation_token_reset(token: *const CancellationToken) {
+    read_raw_pointer(token).reset()
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_cancellation_token_free(token: *mut CancellationToken) {
+    if token.is_null() {
+        return;
+    }
+    drop(unsafe { Box::from_raw(token) });
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_verify_sc_proof_interruptible(
+    end_epoch_mc_b_hash: *const [c_uchar; 32],
+    prev_end_epoch_mc_b_hash: *const [c_uchar; 32],
+    bt_list: *const BackwardTransfer,
+    bt_list_len: usize,
+    quality: u64,
+    constant: *const FieldElement,
+    proofdata: *const FieldElement,
+    sc_proof: *const SCProof,
+    vk:       *const SCVk,
+    cancellation_token: *const CancellationToken,
+    timeout_ms: u64,
+) -> c_uint {
+
+    //Start the clock as soon as possible
+    let deadline = if timeout_ms != 0 {
+        Some(Instant::now() + Duration::from_millis(timeout_ms))
+    } else {
+        None
+    };
+
+    //Read end_epoch_mc_b_hash
+    let end_epoch_mc_b_hash = read_raw_pointer(end_epoch_mc_b_hash);
+
+    //Read prev_end_epoch_mc_b_hash
+    let prev_end_epoch_mc_b_hash = read_raw_pointer(prev_end_epoch_mc_b_hash);
+
+    //Read bt_list
+    let bt_list = if !bt_list.is_null() {
+        unsafe { slice::from_raw_parts(bt_list, bt_list_len) }
+    } else {
+        &[]
+    };
+
+    //Read constant
+    let constant = read_nullable_raw_pointer(constant);
+
+    //Read proofdata
+    let proofdata = read_nullable_raw_pointer(proofdata);
+
+    //Read SCProof
+    let sc_proof = read_raw_pointer(sc_proof);
+
+    //Read vk
+    let vk = read_raw_pointer(vk);
+
+    let interrupt = VerificationInterrupt {
+        cancellation_token: read_nullable_raw_pointer(cancellation_token),
+        deadline,
+    };
+
+    //Verify proof
+    match ginger_calls::verify_sc_proof_interruptible(
+        end_epoch_mc_b_hash,
+        prev_end_epoch_mc_b_hash,
+        bt_list,
+        quality,
+        constant,
+        proofdata,
+        sc_proof,
+        &vk,
+        &interrupt,
+    ) {
+        Ok(status) => status as u32,
+        Err(e) => {
+            set_last_error(e, CRYPTO_ERROR);
+            VerificationStatus::Error as u32
+        }
+    }
+}
+
+//********************Memory accounting functions********************
+
+#[no_mangle]
+pub extern "C" fn zendoo_get_memory_usage() -> MemoryUsage {
+    MEMORY_TRACKER.usage()
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_set_memory_budget(budget: usize) {
+    MEMORY_TRACKER.set_budget(budget)
+}
+
 //********************Poseidon hash functions********************
 
 #[no_mangle]
@@ -303,7 +842,97 @@ pub extern "C" fn zendoo_compute_poseidon_hash(
     };
 
     //Return pointer to hash
-    Box::into_raw(Box::new(hash))
+    into_tracked_raw_pointer(hash)
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_init_poseidon_inputs() -> *mut PoseidonInputs {
+    into_tracked_raw_pointer(PoseidonInputs::new())
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_add_poseidon_input(
+    inputs: *mut PoseidonInputs,
+    input: *const FieldElement,
+) -> bool {
+    assert!(!inputs.is_null());
+    let inputs = unsafe { &mut *inputs };
+
+    //Read input
+    let input = *read_raw_pointer(input);
+
+    //Account the new input
+    let old_size = inputs.heap_size();
+    if let Err(e) = MEMORY_TRACKER.resize(PoseidonInputs::KIND, old_size, old_size + size_of::<FieldElement>()) {
+        set_last_error(Box::new(e), MEMORY_ERROR);
+        return false;
+    }
+
+    inputs.add(input);
+    true
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_add_poseidon_input_bytes(
+    inputs: *mut PoseidonInputs,
+    input: *const c_uchar,
+    input_len: usize,
+) -> bool {
+    assert!(!inputs.is_null());
+    let inputs = unsafe { &mut *inputs };
+
+    //Read bytes
+    let input = if !input.is_null() {
+        unsafe { slice::from_raw_parts(input, input_len) }
+    } else {
+        &[]
+    };
+
+    //Account the new inputs
+    let old_size = inputs.heap_size();
+    let chunks = (input.len() + POSEIDON_BYTES_CHUNK_SIZE - 1) / POSEIDON_BYTES_CHUNK_SIZE;
+    if let Err(e) = MEMORY_TRACKER.resize(PoseidonInputs::KIND, old_size, old_size + chunks * size_of::<FieldElement>()) {
+        set_last_error(Box::new(e), MEMORY_ERROR);
+        return false;
+    }
+
+    match inputs.add_bytes(input) {
+        Ok(()) => true,
+        Err(e) => {
+            MEMORY_TRACKER.resize(
+                PoseidonInputs::KIND,
+                old_size + chunks * size_of::<FieldElement>(),
+                inputs.heap_size(),
+            ).unwrap();
+            set_last_error(Box::new(e), IO_ERROR);
+            false
+        }
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_hash_poseidon_inputs(
+    inputs: *const PoseidonInputs,
+) -> *mut FieldElement {
+    match read_raw_pointer(inputs).hash() {
+        Ok(hash) => into_tracked_raw_pointer(hash),
+        Err(e) => {
+            set_last_error(e, CRYPTO_ERROR);
+            null_mut()
+        }
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_clone_poseidon_inputs(
+    inputs: *const PoseidonInputs,
+) -> *mut PoseidonInputs {
+    into_tracked_raw_pointer(read_raw_pointer(inputs).clone())
+}
+
+#[no_mangle]
+pub extern "C" fn zendoo_poseidon_inputs_free(inputs: *mut PoseidonInputs) {
+    free_tracked_raw_pointer(inputs)
 }
 
 // ********************Merkle Tree functions********************
@@ -311,33 +940,192 @@ pub extern "C" fn zendoo_compute_poseidon_hash(
 pub extern "C" fn ginger_mt_new(
     leaves: *const *const FieldElement,
     leaves_len: usize,
-) -> *mut GingerMerkleTree {
+) -> *mut GingerMerkleTreeHandle {
 
     //Read leaves
     let leaves = read_double_raw_pointer(leaves, leaves_len);
 
+    //Account the tree before generating it, so that the budget is enforced before allocating
+    let tree_size = merkle_tree_heap_size(leaves.len());
+    if let Err(e) = MEMORY_TRACKER.track(ObjectKind::GingerMerkleTree, tree_size) {
+        set_last_error(Box::new(e), MEMORY_ERROR);
+        return null_mut();
+    }
+
     //Generate tree and compute Merkle Root
-    let gmt = match new_ginger_merkle_tree(leaves.as_slice()) {
+    let gmt = match InMemoryGingerMerkleTree::new(leaves.as_slice()) {
         Ok(tree) => tree,
         Err(e) => {
+            MEMORY_TRACKER.untrack(ObjectKind::GingerMerkleTree, tree_size);
             set_last_error(e, CRYPTO_ERROR);
             return null_mut();
         }
     };
 
-    Box::into_raw(Box::new(gmt))
+    Box::into_raw(Box::new(GingerMerkleTreeHandle::InMemory(gmt)))
 }
 
+fn persistent_tree_to_raw_pointer(
+    tree: Result<PersistentGingerMerkleTree, Error>,
+) -> *mut GingerMerkleTreeHandle {
+    let tree = match tree {
+        Ok(tree) => GingerMerkleTreeHandle::Persistent(tree),
+        Err(e) => {
+            let category = if e.is::<MemoryBudgetError>() { MEMORY_ERROR } else { IO_ERROR };
+            set_last_error(e, category);
+            return null_mut();
+        }
+    };
+    match MEMORY_TRACKER.track(ObjectKind::GingerMerkleTree, tree.heap_size()) {
+        Ok(()) => Box::into_raw(Box::new(tree)),
+        Err(e) => {
+            set_last_error(Box::new(e), MEMORY_ERROR);
+            null_mut()
+        }
+    }
+}
+
+#[cfg(target_os = "windows")]
 #[no_mangle]
-pub extern "C" fn ginger_mt_get_root(tree: *const GingerMerkleTree) -> *mut FieldElement {
-    Box::into_raw(Box::new(get_ginger_merkle_root(read_raw_pointer(tree))))
+pub extern "C" fn ginger_mt_new_persistent(
+    leaves: *const *const FieldElement,
+    leaves_len: usize,
+    tree_path: *const u16,
+    tree_path_len: usize,
+) -> *mut GingerMerkleTreeHandle {
+
+    //Read leaves
+    let leaves = read_double_raw_pointer(leaves, leaves_len);
+
+    // Read tree_path
+    let tree_str = OsString::from_wide(unsafe {
+        slice::from_raw_parts(tree_path, tree_path_len)
+    });
+    let tree_path = Path::new(&tree_str);
+
+    //Generate tree and save its nodes
+    persistent_tree_to_raw_pointer(PersistentGingerMerkleTree::create(leaves.as_slice(), tree_path))
+}
+
+#[cfg(not(target_os = "windows"))]
+#[no_mangle]
+pub extern "C" fn ginger_mt_new_persistent(
+    leaves: *const *const FieldElement,
+    leaves_len: usize,
+    tree_path: *const u8,
+    tree_path_len: usize,
+) -> *mut GingerMerkleTreeHandle {
+
+    //Read leaves
+    let leaves = read_double_raw_pointer(leaves, leaves_len);
+
+    // Read tree_path
+    let tree_path = Path::new(OsStr::from_bytes(unsafe {
+        slice::from_raw_parts(tree_path, tree_path_len)
+    }));
+
+    //Generate tree and save its nodes
+    persistent_tree_to_raw_pointer(PersistentGingerMerkleTree::create(leaves.as_slice(), tree_path))
+}
+
+#[cfg(target_os = "windows")]
+#[no_mangle]
+pub extern "C" fn ginger_mt_open(
+    tree_path: *const u16,
+    tree_path_len: usize,
+) -> *mut GingerMerkleTreeHandle {
+
+    // Read tree_path
+    let tree_str = OsString::from_wide(unsafe {
+        slice::from_raw_parts(tree_path, tree_path_len)
+    });
+    let tree_path = Path::new(&tree_str);
+
+    persistent_tree_to_raw_pointer(PersistentGingerMerkleTree::open(tree_path).map_err(|e| e.into()))
+}
+
+#[cfg(not(target_os = "windows"))]
+#[no_mangle]
+pub extern "C" fn ginger_mt_open(
+    tree_path: *const u8,
+    tree_path_len: usize,
+) -> *mut GingerMerkleTreeHandle {
+
+    // Read tree_path
+    let tree_path = Path::new(OsStr::from_bytes(unsafe {
+        slice::from_raw_parts(tree_path, tree_path_len)
+    }));
+
+    persistent_tree_to_raw_pointer(PersistentGingerMerkleTree::open(tree_path).map_err(|e| e.into()))
+}
+
+#[cfg(target_os = "windows")]
+#[no_mangle]
+pub extern "C" fn ginger_mt_save(
+    tree: *const GingerMerkleTreeHandle,
+    tree_path: *const u16,
+    tree_path_len: usize,
+) -> bool {
+
+    //Read tree
+    let tree = read_raw_pointer(tree);
+
+    // Read tree_path
+    let tree_str = OsString::from_wide(unsafe {
+        slice::from_raw_parts(tree_path, tree_path_len)
+    });
+    let tree_path = Path::new(&tree_str);
+
+    match PersistentGingerMerkleTree::save(tree.nodes(), tree_path) {
+        Ok(()) => true,
+        Err(e) => {
+            set_last_error(e, IO_ERROR);
+            false
+        }
+    }
+}
+
+#[cfg(not(target_os = "windows"))]
+#[no_mangle]
+pub extern "C" fn ginger_mt_save(
+    tree: *const GingerMerkleTreeHandle,
+    tree_path: *const u8,
+    tree_path_len: usize,
+) -> bool {
+
+    //Read tree
+    let tree = read_raw_pointer(tree);
+
+    // Read tree_path
+    let tree_path = Path::new(OsStr::from_bytes(unsafe {
+        slice::from_raw_parts(tree_path, tree_path_len)
+    }));
+
+    match PersistentGingerMerkleTree::save(tree.nodes(), tree_path) {
+        Ok(()) => true,
+        Err(e) => {
+            set_last_error(e, IO_ERROR);
+            false
+        }
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn ginger_mt_get_root(tree: *const GingerMerkleTreeHandle) -> *mut FieldElement {
+    match read_raw_pointer(tree).nodes().root() {
+        Ok(root) => into_tracked_raw_pointer(root),
+        Err(e) => {
+            set_last_error(Box::new(e), IO_ERROR);
+            null_mut()
+        }
+    }
 }
 
 #[no_mangle]
 pub extern "C" fn ginger_mt_get_merkle_path(
     leaf: *const FieldElement,
     leaf_index: usize,
-    tree: *const GingerMerkleTree,
+    tree: *const GingerMerkleTreeHandle,
 ) -> *mut GingerMerkleTreePath {
     //Read tree
     let tree = read_raw_pointer(tree);
@@ -345,7 +1133,7 @@ pub extern "C" fn ginger_mt_get_merkle_path(
     let leaf = read_raw_pointer(leaf);
 
     //Compute Merkle Path
-    let mp = match get_ginger_merkle_path(leaf, leaf_index, tree) {
+    let mp = match tree.nodes().merkle_path(leaf, leaf_index) {
         Ok(path) => path,
         Err(e) => {
             set_last_error(e, CRYPTO_ERROR);
@@ -353,7 +1141,7 @@ pub extern "C" fn ginger_mt_get_merkle_path(
         }
     };
 
-    Box::into_raw(Box::new(mp))
+    into_tracked_raw_pointer(mp)
 }
 
 #[no_mangle]
@@ -383,19 +1171,13 @@ pub extern "C" fn ginger_mt_verify_merkle_path(
 }
 
 #[no_mangle]
-pub extern "C" fn ginger_mt_free(tree: *mut GingerMerkleTree) {
-    if tree.is_null() {
-        return;
-    }
-    drop(unsafe { Box::from_raw(tree) });
+pub extern "C" fn ginger_mt_free(tree: *mut GingerMerkleTreeHandle) {
+    free_tracked_raw_pointer(tree)
 }
 
 #[no_mangle]
 pub extern "C" fn ginger_mt_path_free(path: *mut GingerMerkleTreePath) {
-    if path.is_null() {
-        return;
-    }
-    drop(unsafe { Box::from_raw(path) });
+    free_tracked_raw_pointer(path)
 }
 
 //***************Test functions*******************
@@ -448,6 +1230,80 @@ pub extern "C" fn zendoo_generate_mc_test_params(
     }
 }
 
+#[cfg(all(feature = "mc-test-circuit", target_os = "windows"))]
+#[no_mangle]
+pub extern "C" fn zendoo_generate_mc_test_params_from_seed(
+    params_dir: *const u16,
+    params_dir_len: usize,
+    seed: *const [c_uchar; 32],
+    cache_dir: *const u16,
+    cache_dir_len: usize,
+) -> bool {
+
+    // Read params_dir
+    let params_str = OsString::from_wide(unsafe {
+        slice::from_raw_parts(params_dir, params_dir_len)
+    });
+    let params_dir = Path::new(&params_str);
+
+    //Read seed
+    let seed = read_raw_pointer(seed);
+
+    // Read cache_dir
+    let cache_str = if !cache_dir.is_null() {
+        Some(OsString::from_wide(unsafe {
+            slice::from_raw_parts(cache_dir, cache_dir_len)
+        }))
+    } else {
+        None
+    };
+    let cache_dir = cache_str.as_ref().map(|cache_str| Path::new(cache_str));
+
+    match ginger_calls::generate_test_mc_parameters_from_seed(params_dir, seed, cache_dir) {
+        Ok(()) => true,
+        Err(e) => {
+            set_last_error(e, CRYPTO_ERROR);
+            false
+        }
+    }
+}
+
+#[cfg(all(feature = "mc-test-circuit", not(target_os = "windows")))]
+#[no_mangle]
+pub extern "C" fn zendoo_generate_mc_test_params_from_seed(
+    params_dir: *const u8,
+    params_dir_len: usize,
+    seed: *const [c_uchar; 32],
+    cache_dir: *const u8,
+    cache_dir_len: usize,
+) -> bool {
+
+    // Read params_dir
+    let params_dir = Path::new(OsStr::from_bytes(unsafe {
+        slice::from_raw_parts(params_dir, params_dir_len)
+    }));
+
+    //Read seed
+    let seed = read_raw_pointer(seed);
+
+    // Read cache_dir
+    let cache_dir = if !cache_dir.is_null() {
+        Some(Path::new(OsStr::from_bytes(unsafe {
+            slice::from_raw_parts(cache_dir, cache_dir_len)
+        })))
+    } else {
+        None
+    };
+
+    match ginger_calls::generate_test_mc_parameters_from_seed(params_dir, seed, cache_dir) {
+        Ok(()) => true,
+        Err(e) => {
+            set_last_error(e, CRYPTO_ERROR);
+            false
+        }
+    }
+}
+
 #[cfg(all(feature = "mc-test-circuit", not(target_os = "windows")))]
 #[no_mangle]
 pub extern "C" fn zendoo_deserialize_sc_proof_from_file(
@@ -461,7 +1317,7 @@ pub extern "C" fn zendoo_deserialize_sc_proof_from_file(
     }));
 
     match deserialize_from_file(proof_path){
-        Some(proof) => Box::into_raw(Box::new(proof)),
+        Some(proof) => into_tracked_raw_pointer(proof),
         None => null_mut(),
     }
 }
@@ -480,7 +1336,7 @@ pub extern "C" fn zendoo_deserialize_sc_proof_from_file(
     let proof_path = Path::new(&path_str);
 
     match deserialize_from_file(proof_path){
-        Some(proof) => Box::into_raw(Box::new(proof)),
+        Some(proof) => into_tracked_raw_pointer(proof),
         None => null_mut(),
     }
 }
@@ -498,6 +1354,7 @@ pub extern "C" fn zendoo_create_mc_test_proof(
     pk_path_len: usize,
     proof_path: *const u8,
     proof_path_len: usize,
+    num_threads: usize,
 ) -> bool
 {
     //Read end_epoch_mc_b_hash
@@ -535,6 +1392,7 @@ pub extern "C" fn zendoo_create_mc_test_proof(
         constant,
         pk_path,
         proof_path,
+        num_threads,
     ) {
         Ok(()) => true,
         Err(e) => {
@@ -557,6 +1415,7 @@ pub extern "C" fn zendoo_create_mc_test_proof(
     pk_path_len: usize,
     proof_path: *const u16,
     proof_path_len: usize,
+    num_threads: usize,
 ) -> bool
 {
     //Read end_epoch_mc_b_hash
@@ -596,6 +1455,7 @@ pub extern "C" fn zendoo_create_mc_test_proof(
         constant,
         pk_path,
         proof_path,
+        num_threads,
     ) {
         Ok(()) => true,
         Err(e) => {
@@ -615,7 +1475,7 @@ fn check_equal<T: PartialEq>(val_1: *const T, val_2: *const T) -> bool {
 pub extern "C" fn zendoo_get_random_field() -> *mut FieldElement {
     let mut rng = OsRng;
     let random_f = FieldElement::rand(&mut rng);
-    Box::into_raw(Box::new(random_f))
+    into_tracked_raw_pointer(random_f)
 }
 
 #[no_mangle]
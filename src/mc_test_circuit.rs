@@ -24,7 +24,10 @@ use r1cs_std::{
 use r1cs_crypto::crh::{MNT4PoseidonHashGadget, FieldBasedHashGadget};
 
 use std::marker::PhantomData;
-use rand::rngs::OsRng;
+use rand::{
+    rngs::{OsRng, StdRng},
+    Rng, SeedableRng,
+};
 
 type MNT4FrGadget = FpGadget<MNT4Fr>;
 
@@ -63,9 +66,20 @@ impl<F: PrimeField> MCTestCircuit<F> {
 
     pub fn generate_parameters() -> Result<Parameters<MNT4>, SynthesisError>
     {
-        //Generate parameters, generate and save to file proof and verification key
         let mut rng = OsRng::default();
+        Self::generate_parameters_with_rng(&mut rng)
+    }
+
+    /// Deterministically generate the parameters from `seed`: the same seed
+    /// will always produce the same proving and verification keys.
+    pub fn generate_parameters_from_seed(seed: [u8; 32]) -> Result<Parameters<MNT4>, SynthesisError>
+    {
+        let mut rng = StdRng::from_seed(seed);
+        Self::generate_parameters_with_rng(&mut rng)
+    }
 
+    fn generate_parameters_with_rng<R: Rng>(rng: &mut R) -> Result<Parameters<MNT4>, SynthesisError>
+    {
         // Create parameters for our circuit
         let params = {
             let c = MCTestCircuit::<MNT4Fr> {
@@ -76,7 +90,7 @@ impl<F: PrimeField> MCTestCircuit<F> {
                 constant:                 None,
                 _field:                   PhantomData,
             };
-            generate_random_parameters::<MNT4, _, _>(c, &mut rng)
+            generate_random_parameters::<MNT4, _, _>(c, rng)
         }?;
 
         Ok(params)
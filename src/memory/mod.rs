@@ -0,0 +1,221 @@
+use algebra::curves::mnt4753::G1Affine;
+use crate::ginger_calls::{
+    merkle_tree_heap_size, FieldElement, GingerMerkleTreeHandle, GingerMerkleTreeNodes, GingerMerkleTreePath,
+    PoseidonInputs, SCProof, SCVk,
+};
+use std::{
+    fmt::{Display, Formatter, Result as FmtResult},
+    mem::size_of,
+    sync::atomic::{AtomicUsize, Ordering},
+};
+
+/// Kinds of library-owned objects whose memory is accounted.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ObjectKind {
+    Field = 0,
+    SCProof = 1,
+    SCVk = 2,
+    GingerMerkleTree = 3,
+    GingerMerkleTreePath = 4,
+    PoseidonInputs = 5,
+}
+
+pub const OBJECT_KINDS: usize = 6;
+
+/// Snapshot of the memory held by library-owned objects.
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+#[repr(C)]
+pub struct MemoryUsage {
+    /// Number of live objects, indexed by `ObjectKind`.
+    pub live_objects: [usize; OBJECT_KINDS],
+    /// Bytes held by live objects, indexed by `ObjectKind`.
+    pub live_bytes:   [usize; OBJECT_KINDS],
+    /// Bytes held by live objects, plus the ones reserved while a ginger_mt_new_persistent builds
+    /// its tree in memory.
+    pub total_bytes:  usize,
+    /// Maximum value allowed for `total_bytes` (0 means unlimited).
+    pub budget:       usize,
+}
+
+/// Defining an error to return when the memory budget would be exceeded
+#[derive(Debug, Clone)]
+pub struct MemoryBudgetError {
+    pub requested: usize,
+    pub budget:    usize,
+}
+
+impl Display for MemoryBudgetError {
+    fn fmt(&self, f: &mut Formatter) -> FmtResult {
+        write!(f, "unable to allocate {} bytes: memory budget of {} bytes exceeded", self.requested, self.budget)
+    }
+}
+
+impl std::error::Error for MemoryBudgetError {
+    fn source(&self) -> Option<&(dyn std::error::Error + 'static)> {
+        None
+    }
+}
+
+/// Keeps track of the memory held by library-owned objects and, optionally,
+/// enforces a budget on it.
+pub struct MemoryTracker {
+    live_objects: [AtomicUsize; OBJECT_KINDS],
+    live_bytes:   [AtomicUsize; OBJECT_KINDS],
+    total_bytes:  AtomicUsize,
+    budget:       AtomicUsize,
+}
+
+impl MemoryTracker {
+    pub const fn new() -> Self {
+        Self {
+            live_objects: [
+                AtomicUsize::new(0), AtomicUsize::new(0), AtomicUsize::new(0),
+                AtomicUsize::new(0), AtomicUsize::new(0), AtomicUsize::new(0),
+            ],
+            live_bytes: [
+                AtomicUsize::new(0), AtomicUsize::new(0), AtomicUsize::new(0),
+                AtomicUsize::new(0), AtomicUsize::new(0), AtomicUsize::new(0),
+            ],
+            total_bytes: AtomicUsize::new(0),
+            budget:      AtomicUsize::new(0),
+        }
+    }
+
+    /// Set the maximum number of bytes that can be held (0 means unlimited).
+    /// Memory already held is not affected, even if above the new budget.
+    pub fn set_budget(&self, budget: usize) {
+        self.budget.store(budget, Ordering::Relaxed);
+    }
+
+    pub fn usage(&self) -> MemoryUsage {
+        let mut usage = MemoryUsage::default();
+        for i in 0..OBJECT_KINDS {
+            usage.live_objects[i] = self.live_objects[i].load(Ordering::Relaxed);
+            usage.live_bytes[i] = self.live_bytes[i].load(Ordering::Relaxed);
+        }
+        usage.total_bytes = self.total_bytes.load(Ordering::Relaxed);
+        usage.budget = self.budget.load(Ordering::Relaxed);
+        usage
+    }
+
+    /// Account `bytes` more, failing if this would exceed the budget.
+    pub fn reserve(&self, bytes: usize) -> Result<(), MemoryBudgetError> {
+        let budget = self.budget.load(Ordering::Relaxed);
+        let mut current = self.total_bytes.load(Ordering::Relaxed);
+        loop {
+            let new = current.saturating_add(bytes);
+            if budget != 0 && new > budget {
+                return Err(MemoryBudgetError { requested: bytes, budget });
+            }
+            match self.total_bytes.compare_exchange_weak(current, new, Ordering::Relaxed, Ordering::Relaxed) {
+                Ok(_) => return Ok(()),
+                Err(actual) => current = actual,
+            }
+        }
+    }
+
+    pub fn release(&self, bytes: usize) {
+        self.total_bytes.fetch_sub(bytes, Ordering::Relaxed);
+    }
+
+    /// Like `reserve()`, but the bytes are released when the returned guard is dropped:
+    /// used to charge data held only while a call is running, e.g. the nodes of a persistent
+    /// Merkle tree before they are written to file.
+    pub fn reserve_scoped(&self, bytes: usize) -> Result<MemoryReservation, MemoryBudgetError> {
+        self.reserve(bytes)?;
+        Ok(MemoryReservation { tracker: self, bytes })
+    }
+
+    /// Account a new live object of `kind` holding `bytes`.
+    pub fn track(&self, kind: ObjectKind, bytes: usize) -> Result<(), MemoryBudgetError> {
+        self.reserve(bytes)?;
+        self.live_objects[kind as usize].fetch_add(1, Ordering::Relaxed);
+        self.live_bytes[kind as usize].fetch_add(bytes, Ordering::Relaxed);
+        Ok(())
+    }
+
+    pub fn untrack(&self, kind: ObjectKind, bytes: usize) {
+        self.live_objects[kind as usize].fetch_sub(1, Ordering::Relaxed);
+        self.live_bytes[kind as usize].fetch_sub(bytes, Ordering::Relaxed);
+        self.release(bytes);
+    }
+
+    /// Account a live object of `kind` growing from `old_bytes` to `new_bytes`.
+    pub fn resize(&self, kind: ObjectKind, old_bytes: usize, new_bytes: usize) -> Result<(), MemoryBudgetError> {
+        if new_bytes > old_bytes {
+            self.reserve(new_bytes - old_bytes)?;
+            self.live_bytes[kind as usize].fetch_add(new_bytes - old_bytes, Ordering::Relaxed);
+        } else {
+            self.release(old_bytes - new_bytes);
+            self.live_bytes[kind as usize].fetch_sub(old_bytes - new_bytes, Ordering::Relaxed);
+        }
+        Ok(())
+    }
+}
+
+pub struct MemoryReservation<'a> {
+    tracker: &'a MemoryTracker,
+    bytes:   usize,
+}
+
+impl<'a> Drop for MemoryReservation<'a> {
+    fn drop(&mut self) {
+        self.tracker.release(self.bytes);
+    }
+}
+
+/// The tracker accounting all the objects handed out through FFI.
+pub static MEMORY_TRACKER: MemoryTracker = MemoryTracker::new();
+
+/// Objects which can be handed out through FFI, along with the memory they hold.
+pub trait TrackedObject: Sized {
+    const KIND: ObjectKind;
+
+    fn heap_size(&self) -> usize {
+        size_of::<Self>()
+    }
+}
+
+impl TrackedObject for FieldElement {
+    const KIND: ObjectKind = ObjectKind::Field;
+}
+
+impl TrackedObject for SCProof {
+    const KIND: ObjectKind = ObjectKind::SCProof;
+}
+
+impl TrackedObject for SCVk {
+    const KIND: ObjectKind = ObjectKind::SCVk;
+
+    fn heap_size(&self) -> usize {
+        size_of::<Self>() + self.gamma_abc_g1.len() * size_of::<G1Affine>()
+    }
+}
+
+impl TrackedObject for GingerMerkleTreeHandle {
+    const KIND: ObjectKind = ObjectKind::GingerMerkleTree;
+
+    fn heap_size(&self) -> usize {
+        match self {
+            GingerMerkleTreeHandle::InMemory(tree) => merkle_tree_heap_size(tree.leaves_len()),
+            // Nodes live in the mapped file, not on the heap
+            GingerMerkleTreeHandle::Persistent(_) => size_of::<Self>(),
+        }
+    }
+}
+
+impl TrackedObject for GingerMerkleTreePath {
+    const KIND: ObjectKind = ObjectKind::GingerMerkleTreePath;
+
+    fn heap_size(&self) -> usize {
+        size_of::<Self>() + self.path.len() * size_of::<(FieldElement, bool)>()
+    }
+}
+
+impl TrackedObject for PoseidonInputs {
+    const KIND: ObjectKind = ObjectKind::PoseidonInputs;
+
+    fn heap_size(&self) -> usize {
+        size_of::<Self>() + self.len() * size_of::<FieldElement>()
+    }
+}
@@ -0,0 +1,136 @@
+use algebra::{FromBytes, ToBytes};
+use memmap::Mmap;
+
+use crate::ginger_calls::{
+    get_tmp_path, merkle_tree_heap_size, merkle_tree_nodes_len, Error, FieldBasedMerkleTreeParams,
+    FieldElement, GingerMerkleTreeNodes, InMemoryGingerMerkleTree, FIELD_SIZE,
+};
+use crate::memory::MEMORY_TRACKER;
+use primitives::merkle_tree::field_based_mht::FieldBasedMerkleTreeConfig;
+
+use std::{
+    fs::{self, File},
+    io::{BufWriter, Error as IoError, ErrorKind, Result as IoResult, Write},
+    path::Path,
+};
+
+// File layout of a persisted GingerMerkleTree (all integers are little endian):
+//
+// | magic (4) | version (4) | height (4) | reserved (4) | leaves_len (8) |
+// | node_0 (FIELD_SIZE) | node_1 (FIELD_SIZE) | ... | root (FIELD_SIZE) |
+//
+// Nodes are stored in the order defined by GingerMerkleTreeNodes: root and path
+// queries are plain reads of the nodes and of their siblings, without any hashing.
+
+const MAGIC: &[u8; 4] = b"ZGMT";
+const VERSION: u32 = 2;
+
+const HEADER_SIZE: usize = 24;
+
+fn invalid_data(msg: &str) -> IoError {
+    IoError::new(ErrorKind::InvalidData, msg)
+}
+
+/// A GingerMerkleTree stored in a memory mapped file.
+pub struct PersistentGingerMerkleTree {
+    mmap:       Mmap,
+    leaves_len: usize,
+    root:       FieldElement,
+}
+
+impl PersistentGingerMerkleTree {
+    /// Build a GingerMerkleTree on `leaves`, save it at `file_path` and open it.
+    /// The nodes are computed in memory before being written, so they are charged
+    /// to MEMORY_TRACKER until the tree is saved.
+    pub fn create(leaves: &[FieldElement], file_path: &Path) -> Result<Self, Error> {
+        let _reservation = MEMORY_TRACKER.reserve_scoped(merkle_tree_heap_size(leaves.len()))?;
+        let tree = InMemoryGingerMerkleTree::new(leaves)?;
+        Self::save(&tree, file_path)?;
+
+        Ok(Self::open(file_path)?)
+    }
+
+    /// Save the nodes of `tree` at `file_path`.
+    /// The file is written in a temporary location first, and then renamed, so that an
+    /// existing tree at `file_path` is replaced atomically.
+    pub fn save(tree: &dyn GingerMerkleTreeNodes, file_path: &Path) -> Result<(), Error> {
+        let tmp_path = get_tmp_path(file_path);
+        let written = Self::write(tree, &tmp_path).and_then(|_| Ok(fs::rename(&tmp_path, file_path)?));
+        if written.is_err() {
+            let _ = fs::remove_file(&tmp_path);
+        }
+        written
+    }
+
+    fn write(tree: &dyn GingerMerkleTreeNodes, file_path: &Path) -> Result<(), Error> {
+        let mut fs = BufWriter::new(File::create(file_path)?);
+
+        //Header
+        fs.write_all(MAGIC)?;
+        (VERSION).write(&mut fs)?;
+        (FieldBasedMerkleTreeParams::HEIGHT as u32).write(&mut fs)?;
+        (0u32).write(&mut fs)?;
+        (tree.leaves_len() as u64).write(&mut fs)?;
+
+        //Nodes
+        for i in 0..merkle_tree_nodes_len(tree.leaves_len()) {
+            tree.node(i)?.write(&mut fs)?;
+        }
+
+        fs.flush()?;
+        fs.get_ref().sync_all()?;
+        Ok(())
+    }
+
+    /// Open the tree saved at `file_path`. Only the header and the root are read and checked:
+    /// no hashing is performed, and the rest of the file is paged in on demand.
+    pub fn open(file_path: &Path) -> IoResult<Self> {
+        let file = File::open(file_path)?;
+        let mmap = unsafe { Mmap::map(&file)? };
+
+        if mmap.len() < HEADER_SIZE + FIELD_SIZE || &mmap[..4] != MAGIC {
+            return Err(invalid_data("not a persisted Merkle tree"));
+        }
+
+        let mut header = &mmap[4..HEADER_SIZE];
+        let version = u32::read(&mut header)?;
+        let height = u32::read(&mut header)? as usize;
+        let _reserved = u32::read(&mut header)?;
+        let leaves_len = u64::read(&mut header)? as usize;
+
+        if version != VERSION {
+            return Err(invalid_data("unsupported persisted Merkle tree version"));
+        }
+        if height != FieldBasedMerkleTreeParams::HEIGHT {
+            return Err(invalid_data("unexpected persisted Merkle tree height"));
+        }
+        if leaves_len > 1 << (height - 1) {
+            return Err(invalid_data("persisted Merkle tree is corrupted"));
+        }
+        if HEADER_SIZE + merkle_tree_nodes_len(leaves_len) * FIELD_SIZE != mmap.len() {
+            return Err(invalid_data("persisted Merkle tree is truncated or corrupted"));
+        }
+
+        let root = FieldElement::read(&mmap[mmap.len() - FIELD_SIZE..])?;
+
+        Ok(Self { mmap, leaves_len, root })
+    }
+}
+
+impl GingerMerkleTreeNodes for PersistentGingerMerkleTree {
+    fn leaves_len(&self) -> usize {
+        self.leaves_len
+    }
+
+    fn node(&self, index: usize) -> IoResult<FieldElement> {
+        if index >= merkle_tree_nodes_len(self.leaves_len) {
+            return Err(IoError::new(ErrorKind::InvalidInput, "node index out of bounds"));
+        }
+        let offset = HEADER_SIZE + index * FIELD_SIZE;
+        FieldElement::read(&self.mmap[offset..offset + FIELD_SIZE])
+    }
+
+    fn root(&self) -> IoResult<FieldElement> {
+        Ok(self.root)
+    }
+}
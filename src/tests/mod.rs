@@ -209,20 +209,238 @@ fn verify_zkproof_no_bwt_test() {
     zendoo_field_free(constant);
 }
 
+#[test]
+fn serialization_formats_test() {
+
+    use crate::{
+        zendoo_deserialize_sc_proof_with_format, zendoo_serialize_sc_proof_with_format,
+        zendoo_deserialize_sc_vk_with_format, zendoo_serialize_sc_vk_with_format,
+        zendoo_get_sc_proof_size_in_bytes_with_format, zendoo_get_sc_vk_size_in_bytes_with_format,
+        zendoo_sc_vk_assert_eq,
+    };
+
+    let mut file = File::open("./test_files/sample_proof").unwrap();
+    let proof = Proof::<PairingCurve>::read(&mut file).unwrap();
+
+    let vk = zendoo_deserialize_sc_vk_from_file(
+        path_as_ptr("./test_files/sample_vk"),
+        22,
+    );
+
+    for &(format, proof_size, vk_size) in [(0, 771, 1544), (1, 387, 968)].iter() {
+        assert_eq!(zendoo_get_sc_proof_size_in_bytes_with_format(format), proof_size);
+        assert_eq!(zendoo_get_sc_vk_size_in_bytes_with_format(format), vk_size);
+
+        //Proof round trip
+        let mut proof_bytes = vec![0u8; proof_size];
+        assert!(zendoo_serialize_sc_proof_with_format(&proof, format, proof_bytes.as_mut_ptr(), proof_bytes.len()));
+        let proof_deserialized = zendoo_deserialize_sc_proof_with_format(proof_bytes.as_ptr(), proof_bytes.len(), format);
+        assert!(!proof_deserialized.is_null());
+        assert!(unsafe { &*proof_deserialized } == &proof);
+        zendoo_sc_proof_free(proof_deserialized);
+
+        //Vk round trip
+        let mut vk_bytes = vec![0u8; vk_size];
+        assert!(zendoo_serialize_sc_vk_with_format(vk, format, vk_bytes.as_mut_ptr(), vk_bytes.len()));
+        let vk_deserialized = zendoo_deserialize_sc_vk_with_format(vk_bytes.as_ptr(), vk_bytes.len(), format);
+        assert!(!vk_deserialized.is_null());
+        assert!(zendoo_sc_vk_assert_eq(vk, vk_deserialized));
+        zendoo_sc_vk_free(vk_deserialized);
+    }
+
+    //Negative test: unknown format
+    assert_eq!(zendoo_get_sc_proof_size_in_bytes_with_format(2), 0);
+    let proof_bytes = [0u8; 771];
+    assert!(zendoo_deserialize_sc_proof_with_format(proof_bytes.as_ptr(), 771, 2).is_null());
+
+    //Negative test: buffer size must match the format, and the buffer can't be NULL
+    let mut proof_bytes = vec![0u8; 772];
+    assert!(!zendoo_serialize_sc_proof_with_format(&proof, 0, proof_bytes.as_mut_ptr(), 772));
+    assert!(!zendoo_serialize_sc_proof_with_format(&proof, 0, proof_bytes.as_mut_ptr(), 770));
+    assert!(!zendoo_serialize_sc_proof_with_format(&proof, 0, std::ptr::null_mut(), 771));
+    let mut vk_bytes = vec![0u8; 969];
+    assert!(!zendoo_serialize_sc_vk_with_format(vk, 1, vk_bytes.as_mut_ptr(), 969));
+    assert!(!zendoo_serialize_sc_vk_with_format(vk, 1, std::ptr::null_mut(), 968));
+    assert!(zendoo_serialize_sc_proof_with_format(&proof, 0, proof_bytes.as_mut_ptr(), 771));
+    assert!(zendoo_deserialize_sc_proof_with_format(proof_bytes.as_ptr(), 772, 0).is_null());
+    assert!(zendoo_deserialize_sc_proof_with_format(proof_bytes.as_ptr(), 770, 0).is_null());
+    assert!(zendoo_deserialize_sc_proof_with_format(std::ptr::null(), 771, 0).is_null());
+    assert!(zendoo_deserialize_sc_vk_with_format(std::ptr::null(), 1544, 0).is_null());
+
+    //Negative test: compressed points must be canonically encoded. Proof A takes the first
+    //97 bytes: x, followed by the flags (bit 0: infinity, bit 1: y greatest)
+    let mut proof_bytes = vec![0u8; 387];
+    assert!(zendoo_serialize_sc_proof_with_format(&proof, 1, proof_bytes.as_mut_ptr(), 387));
+    let deserialize_with_a = |x: Option<[u8; 96]>, flags: u8| {
+        let mut bytes = proof_bytes.clone();
+        if let Some(x) = x {
+            bytes[..96].copy_from_slice(&x);
+        }
+        bytes[96] = flags;
+        zendoo_deserialize_sc_proof_with_format(bytes.as_ptr(), 387, 1)
+    };
+    let a_flags = proof_bytes[96];
+
+    //Unknown flags
+    for bit in 2..8 {
+        assert!(deserialize_with_a(None, a_flags | (1 << bit)).is_null());
+    }
+    //Point at infinity with non zero x, or with the y flag set
+    assert!(deserialize_with_a(None, 1).is_null());
+    assert!(deserialize_with_a(Some([0u8; 96]), 3).is_null());
+
+    //The canonical point at infinity is accepted, and serialized back to the same bytes
+    let proof_at_infinity = deserialize_with_a(Some([0u8; 96]), 1);
+    assert!(!proof_at_infinity.is_null());
+    assert!(unsafe { &*proof_at_infinity }.a.infinity);
+    let mut bytes = vec![0u8; 387];
+    assert!(zendoo_serialize_sc_proof_with_format(proof_at_infinity, 1, bytes.as_mut_ptr(), 387));
+    assert_eq!(&bytes[..97], &[&[0u8; 96][..], &[1u8][..]].concat()[..]);
+    assert_eq!(&bytes[97..], &proof_bytes[97..]);
+    zendoo_sc_proof_free(proof_at_infinity);
+
+    zendoo_sc_vk_free(vk);
+}
+
+#[test]
+fn bulk_deserialization_test() {
+
+    use crate::{
+        zendoo_deserialize_sc_proofs, zendoo_deserialize_sc_vks, zendoo_serialize_sc_proof_with_format,
+        zendoo_serialize_sc_vk_with_format, zendoo_sc_vk_assert_eq,
+    };
+    use std::ptr::null_mut;
+
+    let mut file = File::open("./test_files/sample_proof").unwrap();
+    let proof = Proof::<PairingCurve>::read(&mut file).unwrap();
+
+    let vk = zendoo_deserialize_sc_vk_from_file(
+        path_as_ptr("./test_files/sample_vk"),
+        22,
+    );
+
+    let num = 5;
+    for &(format, proof_size, vk_size) in [(0, 771, 1544), (1, 387, 968)].iter() {
+
+        //Lay out the serialized proofs and vks contiguously
+        let mut proofs_bytes = vec![0u8; num * proof_size];
+        let mut vks_bytes = vec![0u8; num * vk_size];
+        for i in 0..num {
+            assert!(zendoo_serialize_sc_proof_with_format(&proof, format, proofs_bytes[i * proof_size..].as_mut_ptr(), proof_size));
+            assert!(zendoo_serialize_sc_vk_with_format(vk, format, vks_bytes[i * vk_size..].as_mut_ptr(), vk_size));
+        }
+
+        let mut proofs = vec![null_mut(); num];
+        assert!(zendoo_deserialize_sc_proofs(proofs_bytes.as_ptr(), num, format, proofs.as_mut_ptr()));
+        for &p in proofs.iter() {
+            assert!(unsafe { &*p } == &proof);
+            zendoo_sc_proof_free(p);
+        }
+
+        let mut vks = vec![null_mut(); num];
+        assert!(zendoo_deserialize_sc_vks(vks_bytes.as_ptr(), num, format, vks.as_mut_ptr()));
+        for &v in vks.iter() {
+            assert!(zendoo_sc_vk_assert_eq(vk, v));
+            zendoo_sc_vk_free(v);
+        }
+
+        //Negative test: if one of the items is invalid, none is returned
+        for b in proofs_bytes[2 * proof_size..3 * proof_size].iter_mut() {
+            *b = 0xff;
+        }
+        let mut proofs = vec![null_mut(); num];
+        assert!(!zendoo_deserialize_sc_proofs(proofs_bytes.as_ptr(), num, format, proofs.as_mut_ptr()));
+        assert!(proofs.iter().all(|p| p.is_null()));
+
+        //Empty lists may come with NULL buffers, non-empty ones may not
+        assert!(zendoo_deserialize_sc_proofs(std::ptr::null(), 0, format, null_mut()));
+        assert!(zendoo_deserialize_sc_vks(std::ptr::null(), 0, format, null_mut()));
+        assert!(!zendoo_deserialize_sc_proofs(std::ptr::null(), num, format, proofs.as_mut_ptr()));
+        assert!(!zendoo_deserialize_sc_vks(vks_bytes.as_ptr(), num, format, null_mut()));
+
+        //Lengths whose size overflows must be rejected
+        assert!(!zendoo_deserialize_sc_proofs(proofs_bytes.as_ptr(), usize::MAX, format, proofs.as_mut_ptr()));
+    }
+
+    zendoo_sc_vk_free(vk);
+}
+
+#[test]
+fn error_codes_test() {
+
+    use crate::{
+        zendoo_deserialize_field_ex, zendoo_deserialize_sc_proof_ex,
+        error::{zendoo_get_last_error, zendoo_clear_error, zendoo_get_error_code_message, ERROR_CODE_OK, ERROR_CODE_INVALID_FIELD, ERROR_CODE_INVALID_SC_PROOF, IO_ERROR},
+    };
+    use std::ptr::null_mut;
+
+    //Positive case: error code is reset
+    let mut error_code = 255;
+    let field = zendoo_deserialize_field_ex(&[0u8; 96], &mut error_code);
+    assert!(!field.is_null());
+    assert_eq!(error_code, ERROR_CODE_OK);
+    zendoo_field_free(field);
+
+    //Negative case: invalid field (bigger than modulus)
+    zendoo_clear_error();
+    let field = zendoo_deserialize_field_ex(&[255u8; 96], &mut error_code);
+    assert!(field.is_null());
+    assert_eq!(error_code, ERROR_CODE_INVALID_FIELD);
+
+    //Last error carries the static message of the code
+    let last_error = unsafe { zendoo_get_last_error() };
+    assert_eq!(last_error.msg, zendoo_get_error_code_message(ERROR_CODE_INVALID_FIELD));
+    assert_eq!(last_error.category, IO_ERROR);
+
+    //Negative case: invalid proof, error code out-parameter is optional
+    let proof = zendoo_deserialize_sc_proof_ex(&[255u8; 771], null_mut());
+    assert!(proof.is_null());
+    let last_error = unsafe { zendoo_get_last_error() };
+    assert_eq!(last_error.msg, zendoo_get_error_code_message(ERROR_CODE_INVALID_SC_PROOF));
+    zendoo_clear_error();
+}
+
+#[cfg(feature = "mc-test-circuit")]
+#[test]
+fn test_prover_pool_test() {
+    use crate::ginger_calls::run_on_test_prover_pool;
+
+    //The prover runs on a pool with the requested number of threads, or on the global one
+    for &num_threads in [2, 2, 3].iter() {
+        let threads = run_on_test_prover_pool(num_threads, || rayon::current_num_threads()).unwrap();
+        assert_eq!(threads, num_threads);
+    }
+    let global_threads = rayon::current_num_threads();
+    assert_eq!(run_on_test_prover_pool(0, || rayon::current_num_threads()).unwrap(), global_threads);
+
+    //Parallel iterators called from it stay on it
+    let used_threads: std::collections::HashSet<_> = run_on_test_prover_pool(2, || {
+        use rayon::prelude::*;
+        (0..1000).into_par_iter().map(|_| rayon::current_thread_index().unwrap()).collect()
+    }).unwrap();
+    assert!(used_threads.iter().all(|&i| i < 2));
+}
+
 #[cfg(feature = "mc-test-circuit")]
 #[test]
 fn create_verify_mc_test_proof(){
 
     use crate::{
-        zendoo_generate_mc_test_params, zendoo_get_random_field, zendoo_create_mc_test_proof,
+        zendoo_generate_mc_test_params_from_seed, zendoo_get_random_field, zendoo_create_mc_test_proof,
         zendoo_deserialize_sc_proof_from_file,
     };
     use rand::Rng;
 
     let mut rng = OsRng::default();
 
-    //Generate params
-    assert!(zendoo_generate_mc_test_params(path_as_ptr("./test_files"), 12));
+    //Generate params (or reuse the ones cached by a previous run)
+    assert!(zendoo_generate_mc_test_params_from_seed(
+        path_as_ptr("./test_files"),
+        12,
+        &[0u8; 32],
+        path_as_ptr("./test_files/mc_test_params_cache"),
+        33
+    ));
 
     //Generate random inputs
     let end_epoch_mc_b_hash: [u8; 32] = [
@@ -262,7 +480,8 @@ fn create_verify_mc_test_proof(){
         pk_path,
         23,
         proof_path,
-        26
+        26,
+        2
     ));
 
     //Verify proof
@@ -306,6 +525,57 @@ fn create_verify_mc_test_proof(){
     ));
 }
 
+#[cfg(feature = "mc-test-circuit")]
+#[test]
+fn seeded_mc_test_params_test(){
+
+    use crate::{
+        zendoo_generate_mc_test_params_from_seed,
+        ginger_calls::get_test_mc_parameters_cache_key,
+    };
+    use std::fs;
+
+    //Same seed and cache of create_verify_mc_test_proof: once the cache is warm, no setup is performed
+    let seed = [0u8; 32];
+    let cache_dir = "./test_files/mc_test_params_cache";
+    let entry_dir = format!("{}/{}", cache_dir, get_test_mc_parameters_cache_key(&seed).unwrap());
+    let params_dirs = ["./test_files/seeded_params_1", "./test_files/seeded_params_2"];
+    let files = ["test_mc_pk", "test_mc_vk"];
+
+    let read_files = |dir: &str| -> Vec<Vec<u8>> {
+        files.iter().map(|file| fs::read(format!("{}/{}", dir, file)).unwrap()).collect()
+    };
+    let modified_times = || -> Vec<std::time::SystemTime> {
+        files.iter().map(|file| {
+            fs::metadata(format!("{}/{}", entry_dir, file)).unwrap().modified().unwrap()
+        }).collect()
+    };
+
+    //First call publishes the entry (if not already there)
+    assert!(zendoo_generate_mc_test_params_from_seed(
+        path_as_ptr(params_dirs[0]), params_dirs[0].len(), &seed, path_as_ptr(cache_dir), cache_dir.len()
+    ));
+    let entry_times = modified_times();
+
+    //Second call must hit the entry, leaving it untouched
+    assert!(zendoo_generate_mc_test_params_from_seed(
+        path_as_ptr(params_dirs[1]), params_dirs[1].len(), &seed, path_as_ptr(cache_dir), cache_dir.len()
+    ));
+    assert_eq!(modified_times(), entry_times);
+
+    //Same seed must lead to the same parameters
+    let entry_files = read_files(&entry_dir);
+    for dir in params_dirs.iter() {
+        assert_eq!(read_files(dir), entry_files);
+        fs::remove_dir_all(dir).unwrap();
+    }
+
+    //Different seeds must be cached under different entries
+    let key_1 = get_test_mc_parameters_cache_key(&[1u8; 32]).unwrap();
+    let key_2 = get_test_mc_parameters_cache_key(&[2u8; 32]).unwrap();
+    assert_ne!(key_1, key_2);
+}
+
 #[test]
 fn merkle_tree_test() {
     let mut rng = OsRng::default();
@@ -364,6 +634,157 @@ fn merkle_tree_test() {
     }
 }
 
+#[test]
+fn streaming_merkle_root_test() {
+    use crate::{
+        zendoo_compute_bt_root_streaming,
+        ginger_calls::GingerMerkleRootCalculator,
+    };
+    use primitives::merkle_tree::field_based_mht::MNT4753_PHANTOM_MERKLE_ROOT;
+
+    let mut rng = OsRng::default();
+
+    //Streaming root must match the one of the full tree, for any number of leaves
+    for &leaves_len in [1, 2, 3, 5, 8, 13, 64, 100].iter() {
+        let fes: Vec<Fr> = (0..leaves_len).map(|_| Fr::rand(&mut rng)).collect();
+        let native_tree = GingerMerkleTree::new(fes.as_slice()).unwrap();
+
+        let mut calculator = GingerMerkleRootCalculator::new();
+        for fe in fes.iter() {
+            calculator.append(*fe).unwrap();
+        }
+        assert_eq!(calculator.leaves_len(), leaves_len);
+        assert_eq!(calculator.root().unwrap(), native_tree.root());
+    }
+
+    //Same for BTs, through FFI
+    let mut bt_list = vec![];
+    for i in 0..7u64 {
+        bt_list.push(BackwardTransfer { pk_dest: [i as u8; 20], amount: i });
+    }
+    let bt_fes: Vec<Fr> = bt_list.iter().map(|bt| bt.to_field_element().unwrap()).collect();
+    let root = zendoo_compute_bt_root_streaming(bt_list.as_ptr(), bt_list.len());
+    assert_eq!(unsafe { *root }, GingerMerkleTree::new(bt_fes.as_slice()).unwrap().root());
+    zendoo_field_free(root);
+
+    //No BTs
+    let root = zendoo_compute_bt_root_streaming(null(), 0);
+    assert_eq!(unsafe { *root }, MNT4753_PHANTOM_MERKLE_ROOT);
+    zendoo_field_free(root);
+}
+
+#[test]
+fn merkle_tree_equivalence_test() {
+    use crate::{
+        ginger_calls::{GingerMerkleRootCalculator, GingerMerkleTreeNodes, InMemoryGingerMerkleTree},
+        persistent_mht::PersistentGingerMerkleTree,
+    };
+
+    let mut rng = OsRng::default();
+    let tree_path = std::path::Path::new("./test_files/equivalence_mt");
+    let max_leaves = GingerMerkleRootCalculator::MAX_LEAVES;
+
+    //Roots and all the paths must be the same of a native tree, both in memory and persisted
+    for &leaves_len in [0, 1, 2, 3, 4, 5, 8, 9, 64, 65, max_leaves / 2 + 1, max_leaves].iter() {
+        let leaves: Vec<Fr> = (0..leaves_len).map(|_| Fr::rand(&mut rng)).collect();
+        let native_tree = GingerMerkleTree::new(leaves.as_slice());
+        let tree = InMemoryGingerMerkleTree::new(leaves.as_slice());
+
+        //An empty tree is built only if the native one is
+        let (native_tree, tree) = match native_tree {
+            Ok(native_tree) => (native_tree, tree.unwrap()),
+            Err(_) => {
+                assert_eq!(leaves_len, 0);
+                assert!(tree.is_err());
+                continue;
+            }
+        };
+
+        PersistentGingerMerkleTree::save(&tree, tree_path).unwrap();
+        let persistent_tree = PersistentGingerMerkleTree::open(tree_path).unwrap();
+
+        for t in [&tree as &dyn GingerMerkleTreeNodes, &persistent_tree].iter() {
+            assert_eq!(t.leaves_len(), leaves_len);
+            assert_eq!(t.root().unwrap(), native_tree.root());
+            for (i, leaf) in leaves.iter().enumerate() {
+                let native_mp = native_tree.generate_proof(i, leaf).unwrap();
+                let path = t.merkle_path(leaf, i).unwrap();
+                assert_eq!(native_mp.path, path.path);
+            }
+            assert!(t.merkle_path(&Fr::rand(&mut rng), leaves_len).is_err());
+        }
+    }
+
+    //More leaves than the tree can hold must be rejected
+    let leaves = vec![Fr::rand(&mut rng); max_leaves + 1];
+    assert!(InMemoryGingerMerkleTree::new(leaves.as_slice()).is_err());
+
+    std::fs::remove_file(tree_path).unwrap();
+}
+
+#[test]
+fn persistent_merkle_tree_test() {
+    use crate::{ginger_mt_new_persistent, ginger_mt_open, ginger_mt_save};
+
+    let mut rng = OsRng::default();
+    let tree_path = "./test_files/persistent_mt";
+    let saved_tree_path = "./test_files/saved_mt";
+
+    //Generate random field elements
+    let mut fes = vec![];
+    for _ in 0..10 {
+        fes.push(Fr::rand(&mut rng));
+    }
+    let fes_ptr: Vec<*const Fr> = fes.iter().map(|fe| fe as *const Fr).collect();
+
+    //Get native Merkle Tree
+    let native_tree = GingerMerkleTree::new(fes.as_slice()).unwrap();
+
+    //Create the persistent tree, then reopen it from file, and compare both with the native one
+    let tree = ginger_mt_new_persistent(fes_ptr.as_ptr(), 10, path_as_ptr(tree_path), tree_path.len());
+    assert!(!tree.is_null());
+    let reopened_tree = ginger_mt_open(path_as_ptr(tree_path), tree_path.len());
+    assert!(!reopened_tree.is_null());
+
+    //Save an in-memory tree, then reopen it from file too
+    let in_memory_tree = ginger_mt_new(fes_ptr.as_ptr(), 10);
+    assert!(!in_memory_tree.is_null());
+    assert!(ginger_mt_save(in_memory_tree, path_as_ptr(saved_tree_path), saved_tree_path.len()));
+    ginger_mt_free(in_memory_tree);
+    let saved_tree = ginger_mt_open(path_as_ptr(saved_tree_path), saved_tree_path.len());
+    assert!(!saved_tree.is_null());
+
+    for &t in [tree, reopened_tree, saved_tree].iter() {
+        let root = ginger_mt_get_root(t);
+        assert_eq!(unsafe { *root }, native_tree.root());
+
+        for i in 0..10 {
+            let native_mp = native_tree.generate_proof(i, &fes[i]).unwrap();
+            let path = ginger_mt_get_merkle_path(fes_ptr[i], i, t);
+            assert_slice_equals(native_mp.path.as_slice(), unsafe { &*path }.path.as_slice());
+            assert!(ginger_mt_verify_merkle_path(fes_ptr[i], root, path));
+            ginger_mt_path_free(path);
+        }
+
+        //Wrong leaf and out of bounds index must be rejected
+        assert!(ginger_mt_get_merkle_path(fes_ptr[1], 0, t).is_null());
+        assert!(ginger_mt_get_merkle_path(fes_ptr[0], 10, t).is_null());
+
+        zendoo_field_free(root);
+        ginger_mt_free(t);
+    }
+
+    //A truncated file must be rejected
+    let file = std::fs::OpenOptions::new().write(true).open(tree_path).unwrap();
+    let len = file.metadata().unwrap().len();
+    file.set_len(len - 1).unwrap();
+    drop(file);
+    assert!(ginger_mt_open(path_as_ptr(tree_path), tree_path.len()).is_null());
+
+    std::fs::remove_file(tree_path).unwrap();
+    std::fs::remove_file(saved_tree_path).unwrap();
+}
+
 #[test]
 fn poseidon_hash_test() {
     let lhs: [u8; 96] = [
@@ -410,3 +831,258 @@ fn poseidon_hash_test() {
     zendoo_field_free(expected_hash);
     zendoo_field_free(actual_hash);
 }
+
+#[test]
+fn poseidon_inputs_test() {
+
+    use crate::{
+        zendoo_init_poseidon_inputs, zendoo_add_poseidon_input, zendoo_add_poseidon_input_bytes,
+        zendoo_hash_poseidon_inputs, zendoo_clone_poseidon_inputs, zendoo_poseidon_inputs_free,
+        ginger_calls::{compute_poseidon_hash, read_field_element_from_buffer_with_padding},
+    };
+
+    let mut rng = OsRng::default();
+    let prefix = Fr::rand(&mut rng);
+    let fes = vec![Fr::rand(&mut rng), Fr::rand(&mut rng)];
+
+    //Add the common prefix to a buffer, then copy it for each message
+    let prefix_inputs = zendoo_init_poseidon_inputs();
+    assert!(zendoo_add_poseidon_input(prefix_inputs, &prefix));
+
+    for fe in fes.iter() {
+        let inputs = zendoo_clone_poseidon_inputs(prefix_inputs);
+        assert!(zendoo_add_poseidon_input(inputs, fe));
+
+        let expected_hash = compute_poseidon_hash(&[prefix, *fe]).unwrap();
+        let actual_hash = zendoo_hash_poseidon_inputs(inputs);
+        assert_eq!(unsafe { *actual_hash }, expected_hash);
+
+        zendoo_field_free(actual_hash);
+        zendoo_poseidon_inputs_free(inputs);
+    }
+
+    //Prefix inputs must be unaffected by the additions to their copies
+    let prefix_hash = zendoo_hash_poseidon_inputs(prefix_inputs);
+    assert_eq!(unsafe { *prefix_hash }, compute_poseidon_hash(&[prefix]).unwrap());
+    zendoo_field_free(prefix_hash);
+
+    //Bytes are added in chunks of 94 bytes
+    let bytes = [7u8; 100];
+    assert!(zendoo_add_poseidon_input_bytes(prefix_inputs, bytes.as_ptr(), bytes.len()));
+    let expected_hash = compute_poseidon_hash(&[
+        prefix,
+        read_field_element_from_buffer_with_padding(&bytes[..94]).unwrap(),
+        read_field_element_from_buffer_with_padding(&bytes[94..]).unwrap(),
+    ]).unwrap();
+    let actual_hash = zendoo_hash_poseidon_inputs(prefix_inputs);
+    assert_eq!(unsafe { *actual_hash }, expected_hash);
+
+    zendoo_field_free(actual_hash);
+    zendoo_poseidon_inputs_free(prefix_inputs);
+}
+
+#[test]
+fn fixed_arity_poseidon_test() {
+
+    use crate::ginger_calls::{
+        compute_merkle_node_hash, compute_wcert_sysdata_hash, compute_aggregated_input_hash,
+        get_bt_merkle_root, read_field_element_from_buffer_with_padding, read_field_element_from_u64,
+    };
+    use proof_systems::groth16::{prepare_verifying_key, verifier::verify_proof};
+
+    //Known answer for the certificate hashes: the sample proof only verifies if the public
+    //input, computed from its sample inputs, is the one it was created with
+    let mut file = File::open("./test_files/sample_proof").unwrap();
+    let proof = Proof::<PairingCurve>::read(&mut file).unwrap();
+    let vk = zendoo_deserialize_sc_vk_from_file(
+        path_as_ptr("./test_files/sample_vk"),
+        22,
+    );
+
+    let end_epoch_mc_b_hash: [u8; 32] = [
+        78, 85, 161, 67, 167, 192, 185, 56, 133, 49, 134, 253, 133, 165, 182, 80, 152, 93, 203, 77,
+        165, 13, 67, 0, 64, 200, 185, 46, 93, 135, 238, 70
+    ];
+    let prev_end_epoch_mc_b_hash: [u8; 32] = [
+        68, 214, 34, 70, 20, 109, 48, 39, 210, 156, 109, 60, 139, 15, 102, 79, 79, 2, 87, 190, 118,
+        38, 54, 18, 170, 67, 212, 205, 183, 115, 182, 198
+    ];
+    let constant_bytes: [u8; 96] = [
+        170, 190, 140, 27, 234, 135, 240, 226, 158, 16, 29, 161, 178, 36, 69, 34, 29, 75, 195, 247,
+        29, 93, 92, 48, 214, 102, 70, 134, 68, 165, 170, 201, 119, 162, 19, 254, 229, 115, 80, 248,
+        106, 182, 164, 40, 21, 154, 15, 177, 158, 16, 172, 169, 189, 253, 206, 182, 72, 183, 128,
+        160, 182, 39, 98, 76, 95, 198, 62, 39, 87, 213, 251, 12, 154, 180, 125, 231, 222, 73, 129,
+        120, 144, 197, 116, 248, 95, 206, 147, 108, 252, 125, 79, 118, 57, 26, 0, 0
+    ];
+    let constant = Fr::read(&constant_bytes[..]).unwrap();
+    let bt_list: Vec<BackwardTransfer> = (0..10).map(|_| BackwardTransfer { pk_dest: [0u8; 20], amount: 0 }).collect();
+
+    let wcert_sysdata_hash = compute_wcert_sysdata_hash(
+        &read_field_element_from_u64(2),
+        &get_bt_merkle_root(bt_list.as_slice()).unwrap(),
+        &read_field_element_from_buffer_with_padding(&prev_end_epoch_mc_b_hash).unwrap(),
+        &read_field_element_from_buffer_with_padding(&end_epoch_mc_b_hash).unwrap(),
+    ).unwrap();
+    let pvk = prepare_verifying_key(unsafe { &*vk });
+    let verify = |public_input: Fr| verify_proof(&pvk, &proof, &[public_input]).unwrap();
+
+    let public_input = compute_aggregated_input_hash(Some(&constant), None, &wcert_sysdata_hash).unwrap();
+    assert!(verify(public_input));
+    assert!(!verify(compute_aggregated_input_hash(None, None, &wcert_sysdata_hash).unwrap()));
+    assert!(!verify(compute_aggregated_input_hash(Some(&constant), Some(&constant), &wcert_sysdata_hash).unwrap()));
+
+    zendoo_sc_vk_free(vk);
+
+    //Known answer for the Merkle node hash: folding a Merkle path of a GingerMerkleTree with it
+    //must give the tree root
+    let mut rng = OsRng::default();
+    let leaves: Vec<Fr> = (0..2).map(|_| Fr::rand(&mut rng)).collect();
+    let native_tree = GingerMerkleTree::new(leaves.as_slice()).unwrap();
+    let native_path = native_tree.generate_proof(0, &leaves[0]).unwrap();
+    assert_eq!(native_path.path[0].0, leaves[1]);
+
+    let mut node = compute_merkle_node_hash(&leaves[0], &leaves[1]).unwrap();
+    for (sibling, _) in native_path.path[1..].iter() {
+        node = compute_merkle_node_hash(&node, sibling).unwrap();
+    }
+    assert_eq!(node, native_tree.root());
+}
+
+#[test]
+fn memory_tracker_test() {
+
+    use crate::{
+        zendoo_get_memory_usage, zendoo_get_random_field,
+        memory::{MemoryTracker, ObjectKind},
+    };
+
+    //Objects handed out through FFI are accounted (other tests may hold some too)
+    let field = zendoo_get_random_field();
+    let usage = zendoo_get_memory_usage();
+    assert!(usage.live_objects[ObjectKind::Field as usize] >= 1);
+    assert!(usage.live_bytes[ObjectKind::Field as usize] >= 96);
+    zendoo_field_free(field);
+
+    //Budget is enforced on a local tracker, not to interfere with the other tests
+    let tracker = MemoryTracker::new();
+    tracker.set_budget(1000);
+
+    tracker.track(ObjectKind::SCVk, 600).unwrap();
+    assert!(tracker.track(ObjectKind::SCVk, 600).is_err());
+    {
+        let _reservation = tracker.reserve_scoped(400).unwrap();
+        assert_eq!(tracker.usage().total_bytes, 1000);
+        assert!(tracker.reserve_scoped(1).is_err());
+    }
+    assert_eq!(tracker.usage().total_bytes, 600);
+
+    tracker.resize(ObjectKind::SCVk, 600, 900).unwrap();
+    assert!(tracker.resize(ObjectKind::SCVk, 900, 1001).is_err());
+
+    let usage = tracker.usage();
+    assert_eq!(usage.live_objects[ObjectKind::SCVk as usize], 1);
+    assert_eq!(usage.live_bytes[ObjectKind::SCVk as usize], 900);
+
+    tracker.untrack(ObjectKind::SCVk, 900);
+    let usage = tracker.usage();
+    assert_eq!(usage.live_objects[ObjectKind::SCVk as usize], 0);
+    assert_eq!(usage.total_bytes, 0);
+}
+
+#[test]
+fn verify_zkproof_interruptible_test() {
+
+    use crate::{
+        zendoo_verify_sc_proof_interruptible, zendoo_cancellation_token_new, zendoo_cancellation_token_cancel,
+        zendoo_cancellation_token_reset, zendoo_cancellation_token_free,
+        ginger_calls::{self, VerificationInterrupt, VerificationStatus},
+    };
+    use std::time::Instant;
+
+    let mut file = File::open("./test_files/sample_proof").unwrap();
+    let proof = Proof::<PairingCurve>::read(&mut file).unwrap();
+
+    //Inputs
+    let end_epoch_mc_b_hash: [u8; 32] = [
+        78, 85, 161, 67, 167, 192, 185, 56, 133, 49, 134, 253, 133, 165, 182, 80, 152, 93, 203, 77,
+        165, 13, 67, 0, 64, 200, 185, 46, 93, 135, 238, 70
+    ];
+
+    let prev_end_epoch_mc_b_hash: [u8; 32] = [
+        68, 214, 34, 70, 20, 109, 48, 39, 210, 156, 109, 60, 139, 15, 102, 79, 79, 2, 87, 190, 118,
+        38, 54, 18, 170, 67, 212, 205, 183, 115, 182, 198
+    ];
+
+    let constant_bytes: [u8; 96] = [
+        170, 190, 140, 27, 234, 135, 240, 226, 158, 16, 29, 161, 178, 36, 69, 34, 29, 75, 195, 247,
+        29, 93, 92, 48, 214, 102, 70, 134, 68, 165, 170, 201, 119, 162, 19, 254, 229, 115, 80, 248,
+        106, 182, 164, 40, 21, 154, 15, 177, 158, 16, 172, 169, 189, 253, 206, 182, 72, 183, 128,
+        160, 182, 39, 98, 76, 95, 198, 62, 39, 87, 213, 251, 12, 154, 180, 125, 231, 222, 73, 129,
+        120, 144, 197, 116, 248, 95, 206, 147, 108, 252, 125, 79, 118, 57, 26, 0, 0
+    ];
+    let constant = zendoo_deserialize_field(&constant_bytes);
+
+    let quality = 2;
+
+    let bt_num = 10;
+    let mut bt_list = vec![];
+    for _ in 0..bt_num {
+        bt_list.push(BackwardTransfer {
+            pk_dest: [0u8; 20],
+            amount: 0,
+        });
+    }
+
+    let vk = zendoo_deserialize_sc_vk_from_file(
+        path_as_ptr("./test_files/sample_vk"),
+        22,
+    );
+
+    let token = zendoo_cancellation_token_new();
+
+    let verify = |quality: u64, timeout_ms: u64| zendoo_verify_sc_proof_interruptible(
+        &end_epoch_mc_b_hash,
+        &prev_end_epoch_mc_b_hash,
+        bt_list.as_ptr(),
+        bt_num,
+        quality,
+        constant,
+        null(),
+        &proof,
+        vk,
+        token,
+        timeout_ms,
+    );
+
+    //Not interrupted: same outcome of the non interruptible verification
+    assert_eq!(verify(quality, 0), VerificationStatus::Valid as u32);
+    assert_eq!(verify(quality - 1, 0), VerificationStatus::Invalid as u32);
+    assert_eq!(verify(quality, 60_000), VerificationStatus::Valid as u32);
+
+    //Cancelled
+    zendoo_cancellation_token_cancel(token);
+    assert_eq!(verify(quality, 0), VerificationStatus::Cancelled as u32);
+
+    //Token can be reused
+    zendoo_cancellation_token_reset(token);
+    assert_eq!(verify(quality, 0), VerificationStatus::Valid as u32);
+
+    //Deadline already expired when the verification starts
+    let interrupt = VerificationInterrupt { cancellation_token: None, deadline: Some(Instant::now()) };
+    let status = ginger_calls::verify_sc_proof_interruptible(
+        &end_epoch_mc_b_hash,
+        &prev_end_epoch_mc_b_hash,
+        bt_list.as_slice(),
+        quality,
+        Some(unsafe { &*constant }),
+        None,
+        &proof,
+        unsafe { &*vk },
+        &interrupt,
+    ).unwrap();
+    assert_eq!(status, VerificationStatus::DeadlineExceeded);
+
+    zendoo_cancellation_token_free(token);
+    zendoo_sc_vk_free(vk);
+    zendoo_field_free(constant);
+}